@@ -115,6 +115,11 @@ void Apper::activate(const QStringList& arguments, const QString& workingDirecto
     QCommandLineOption removeOpt(QStringList() << QLatin1String("remove-package-by-file"), i18n("Single package remover"), QLatin1String("filename"));
     parser.addOption(removeOpt);
 
+    // Only listed for --help, main() prints the stats before
+    // the unique instance is registered
+    QCommandLineOption statsOpt(QStringList() << QLatin1String("transaction-stats"), i18n("Print the transaction timings recorded by apperd"));
+    parser.addOption(statsOpt);
+
     parser.addPositionalArgument(QLatin1String("[package]"), i18n("Package file to install"));
 
     KAboutData::applicationData().setupCommandLine(&parser);
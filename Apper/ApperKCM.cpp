@@ -409,7 +409,7 @@ void ApperKCM::on_homeView_activated(const QModelIndex &index)
         if (m_searchRole == Transaction::RoleResolve) {
 #ifdef HAVE_APPSTREAM
             CategoryMatcher parser = index.data(CategoryModel::CategoryRole).value<CategoryMatcher>();
-//            m_searchCategory = AppStream::instance()->findPkgNames(parser);
+            m_searchCategory = AppStreamHelper::instance()->findPkgNames(parser);
 #endif // HAVE_APPSTREAM
         } else if (m_searchRole == Transaction::RoleSearchGroup) {
             if (index.data(CategoryModel::GroupRole).type() == QVariant::String) {
@@ -855,6 +855,8 @@ void ApperKCM::save()
 
         transaction->deleteLater();
         if (currentWidget == m_updaterPage) {
+            // Earlier batches might be installed, offer what is left
+            m_updaterPage->setResumePackages(transaction->resumePackages());
             m_updaterPage->getUpdates();
             setPage(QLatin1String("updates"));
         } else {
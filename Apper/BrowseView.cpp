@@ -22,11 +22,18 @@
 
 #include "PackageDetails.h"
 #include "CategoryModel.h"
+#include "ScreenshotCache.h"
 
 #include <ApplicationsDelegate.h>
 #include <ApplicationSortFilterModel.h>
 #include <PackageModel.h>
 
+#include <config.h>
+
+#ifdef HAVE_APPSTREAM
+#include <AppStream.h>
+#endif
+
 #include <Daemon>
 
 #include <QFileDialog>
@@ -41,6 +48,7 @@
 #include <QDBusMessage>
 #include <QAbstractItemView>
 #include <QScrollBar>
+#include <QTimer>
 
 #include <QLoggingCategory>
 
@@ -115,6 +123,19 @@ BrowseView::BrowseView(QWidget *parent)
 
     // Ensure the index is visible when the packageDetails appears
     connect(packageDetails, &PackageDetails::ensureVisible, this, &BrowseView::ensureVisible);
+
+    // Download the thumbnails of the visible rows once scrolling stops
+    m_prefetchTimer = new QTimer(this);
+    m_prefetchTimer->setSingleShot(true);
+    m_prefetchTimer->setInterval(300);
+    connect(m_prefetchTimer, &QTimer::timeout, this, &BrowseView::prefetchThumbnails);
+    connect(packageView->verticalScrollBar(), &QScrollBar::valueChanged, m_prefetchTimer, static_cast<void(QTimer::*)()>(&QTimer::start));
+    connect(m_proxy, &QAbstractItemModel::rowsInserted, m_prefetchTimer, static_cast<void(QTimer::*)()>(&QTimer::start));
+    connect(m_proxy, &QAbstractItemModel::layoutChanged, m_prefetchTimer, static_cast<void(QTimer::*)()>(&QTimer::start));
+    connect(m_proxy, &QAbstractItemModel::modelReset, m_prefetchTimer, static_cast<void(QTimer::*)()>(&QTimer::start));
+#ifdef HAVE_APPSTREAM
+    connect(AppStreamHelper::instance(), &AppStreamHelper::ready, m_prefetchTimer, static_cast<void(QTimer::*)()>(&QTimer::start));
+#endif // HAVE_APPSTREAM
 }
 
 void BrowseView::init(Transaction::Roles roles)
@@ -193,6 +214,16 @@ void BrowseView::on_packageView_clicked(const QModelIndex &index)
 
     QModelIndex origIndex = m_proxy->mapToSource(index);
     packageDetails->setPackage(origIndex);
+
+    // The user is likely to look at the neighbours next
+    QStringList packageIDs;
+    for (int row = index.row() - 2; row <= index.row() + 2; ++row) {
+        const QModelIndex sibling = index.sibling(row, PackageModel::NameCol);
+        if (row != index.row() && sibling.isValid()) {
+            packageIDs << sibling.data(PackageModel::IdRole).toString();
+        }
+    }
+    packageDetails->prefetchDetails(packageIDs);
 }
 
 void BrowseView::ensureVisible(const QModelIndex &index)
@@ -201,6 +232,27 @@ void BrowseView::ensureVisible(const QModelIndex &index)
     packageView->scrollTo(proxIndex);
 }
 
+void BrowseView::prefetchThumbnails()
+{
+#ifdef HAVE_APPSTREAM
+    if (!isVisible()) {
+        return;
+    }
+
+    QList<QUrl> urls;
+    const QRect viewport = packageView->viewport()->rect();
+    QModelIndex index = packageView->indexAt(viewport.topLeft());
+    while (index.isValid() && packageView->visualRect(index).top() <= viewport.bottom()) {
+        const QUrl url = AppStreamHelper::instance()->thumbnail(index.data(PackageModel::PackageName).toString());
+        if (!url.isEmpty()) {
+            urls << url;
+        }
+        index = packageView->indexBelow(index);
+    }
+    ScreenshotCache::instance()->prefetch(urls);
+#endif // HAVE_APPSTREAM
+}
+
 void BrowseView::showInstalledPanel(bool visible)
 {
     installedF->setVisible(visible);
@@ -23,6 +23,7 @@
 
 #include "ui_BrowseView.h"
 
+class QTimer;
 class PackageModel;
 
 class ApplicationSortFilterModel;
@@ -65,6 +66,8 @@ private Q_SLOTS:
     void on_categoryMvLeft_clicked();
     void on_categoryMvRight_clicked();
 
+    void prefetchThumbnails();
+
     void on_exportInstalledPB_clicked();
     void on_importInstalledPB_clicked();
 
@@ -79,6 +82,7 @@ private:
     ApplicationSortFilterModel    *m_proxy;
     KpkSearchableTreeView         *m_packageView;
     KPixmapSequenceOverlayPainter *m_busySeq;
+    QTimer                        *m_prefetchTimer;
 };
 
 #endif
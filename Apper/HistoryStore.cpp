@@ -0,0 +1,427 @@
+/***************************************************************************
+ *   Copyright (C) 2026 by agent                                           *
+ *   agent@local                                                           *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; see the file COPYING. If not, write to       *
+ *   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,  *
+ *   Boston, MA 02110-1301, USA.                                           *
+ ***************************************************************************/
+
+#include "HistoryStore.h"
+
+#include <Daemon>
+
+#include <QApplication>
+#include <QDir>
+#include <QFileInfo>
+#include <QFutureWatcher>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QStandardPaths>
+#include <QThread>
+#include <QVariant>
+#include <QtConcurrentRun>
+
+#include <QLoggingCategory>
+
+// Bump when the schema changes, the store is rebuilt from PackageKit
+#define STORE_VERSION      1
+// Transactions asked first on an incremental sync
+#define SYNC_FIRST_REQUEST 20
+
+Q_DECLARE_LOGGING_CATEGORY(APPER)
+
+using namespace PackageKit;
+
+HistoryStore* HistoryStore::instance()
+{
+    static HistoryStore *store = nullptr;
+    if (!store) {
+        const QString fileName = QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation) + QLatin1String("/apper/history.sqlite");
+        store = new HistoryStore(fileName, qApp);
+        store->sync();
+    }
+    return store;
+}
+
+HistoryStore::HistoryStore(const QString &fileName, QObject *parent)
+ : QObject(parent),
+   m_fileName(fileName),
+   m_connectionName(QLatin1String("apper-history-") + QString::number(reinterpret_cast<quintptr>(this), 16))
+{
+    // Creating the schema or writing a whole history takes a while,
+    // so all the writing happens on a worker thread, with its own
+    // connection; the GUI only reads, once the store is ready
+    m_openWatcher = new QFutureWatcher<qint64>(this);
+    connect(m_openWatcher, &QFutureWatcher<qint64>::finished, this, &HistoryStore::opened);
+    m_commitWatcher = new QFutureWatcher<qint64>(this);
+    connect(m_commitWatcher, &QFutureWatcher<qint64>::finished, this, &HistoryStore::committed);
+    m_openWatcher->setFuture(QtConcurrent::run(&HistoryStore::openStore, fileName));
+
+    // A change in the package database means new history
+    connect(Daemon::global(), &Daemon::updatesChanged, this, &HistoryStore::sync);
+}
+
+HistoryStore::~HistoryStore()
+{
+    m_openWatcher->waitForFinished();
+    m_commitWatcher->waitForFinished();
+
+    if (m_ready) {
+        m_db.close();
+        m_db = QSqlDatabase();
+        QSqlDatabase::removeDatabase(m_connectionName);
+    }
+}
+
+bool HistoryStore::isValid() const
+{
+    // Optimistic while opening, synced() tells when that failed
+    return !m_failed;
+}
+
+bool HistoryStore::isReady() const
+{
+    return m_ready;
+}
+
+bool HistoryStore::isSyncing() const
+{
+    return m_transaction != nullptr || m_commitWatcher->isRunning() || (!m_ready && !m_failed);
+}
+
+void HistoryStore::sync()
+{
+    if (m_failed) {
+        emit synced();
+        return;
+    }
+
+    if (!m_ready || m_transaction || m_commitWatcher->isRunning()) {
+        m_syncAgain = true;
+        return;
+    }
+
+    // Start small, most of the time only a few transactions are new,
+    // an empty store has to copy everything anyway
+    request(m_newest ? SYNC_FIRST_REQUEST : 0);
+}
+
+QVector<HistoryStore::Entry> HistoryStore::transactions(int offset, int limit, const QString &search) const
+{
+    QVector<Entry> ret;
+    if (!m_ready) {
+        return ret;
+    }
+
+    QSqlQuery query(m_db);
+    if (search.isEmpty()) {
+        query.prepare(QLatin1String("SELECT tid, timespec, role, uid, cmdline, data FROM transactions "
+                                    "ORDER BY timespec DESC LIMIT ? OFFSET ?"));
+    } else {
+        QString escaped = search;
+        escaped.replace(QLatin1Char('\\'), QLatin1String("\\\\"));
+        escaped.replace(QLatin1Char('%'), QLatin1String("\\%"));
+        escaped.replace(QLatin1Char('_'), QLatin1String("\\_"));
+
+        // The prefix match on the package name is answered by its index
+        query.prepare(QLatin1String("SELECT tid, timespec, role, uid, cmdline, data FROM transactions "
+                                    "WHERE tid IN (SELECT tid FROM packages WHERE name LIKE ? ESCAPE '\\') "
+                                    "OR cmdline LIKE ? ESCAPE '\\' "
+                                    "ORDER BY timespec DESC LIMIT ? OFFSET ?"));
+        query.addBindValue(escaped + QLatin1Char('%'));
+        query.addBindValue(QLatin1Char('%') + escaped + QLatin1Char('%'));
+    }
+    query.addBindValue(limit);
+    query.addBindValue(offset);
+
+    if (!query.exec()) {
+        qCWarning(APPER) << "Failed to query history store" << query.lastError().text();
+        return ret;
+    }
+
+    while (query.next()) {
+        Entry entry;
+        entry.tid = query.value(0).toString();
+        entry.timespec = QDateTime::fromMSecsSinceEpoch(query.value(1).toLongLong());
+        entry.role = static_cast<Transaction::Role>(query.value(2).toInt());
+        entry.uid = query.value(3).toUInt();
+        entry.cmdline = query.value(4).toString();
+        entry.data = query.value(5).toString();
+        ret << entry;
+    }
+    return ret;
+}
+
+QVector<HistoryStore::PackageEvent> HistoryStore::packageHistory(const QString &packageName, int limit) const
+{
+    QVector<PackageEvent> ret;
+    if (!m_ready) {
+        // Nothing to tell until the store is open
+        return ret;
+    }
+
+    QSqlQuery query(m_db);
+    query.prepare(QLatin1String("SELECT p.timespec, p.info, p.package_id, t.uid, t.cmdline "
+                                "FROM packages p JOIN transactions t ON t.tid = p.tid "
+                                "WHERE p.name = ? ORDER BY p.timespec DESC LIMIT ?"));
+    query.addBindValue(packageName);
+    query.addBindValue(limit);
+    if (!query.exec()) {
+        qCWarning(APPER) << "Failed to query history store" << query.lastError().text();
+        return ret;
+    }
+
+    while (query.next()) {
+        PackageEvent event;
+        event.timespec = QDateTime::fromMSecsSinceEpoch(query.value(0).toLongLong());
+        event.info = static_cast<Transaction::Info>(query.value(1).toInt());
+        event.packageID = query.value(2).toString();
+        event.uid = query.value(3).toUInt();
+        event.cmdline = query.value(4).toString();
+        ret << event;
+    }
+    return ret;
+}
+
+void HistoryStore::transaction(PackageKit::Transaction *trans)
+{
+    ++m_received;
+
+    const qint64 timespec = trans->timespec().toMSecsSinceEpoch();
+    if (timespec <= m_newest) {
+        // From here on PackageKit only sends what we already have,
+        // the ones at the same time are kept as tids are unique
+        m_reachedKnown = true;
+    }
+
+    if (timespec >= m_newest) {
+        Entry entry;
+        entry.tid = trans->tid().path();
+        entry.timespec = trans->timespec();
+        entry.role = trans->role();
+        entry.uid = trans->uid();
+        entry.cmdline = trans->cmdline();
+        entry.data = trans->data();
+        m_pending << entry;
+    }
+    delete trans;
+}
+
+void HistoryStore::requestFinished()
+{
+    m_transaction = nullptr;
+
+    if (!m_reachedKnown && m_requested != 0 && m_received == m_requested) {
+        // Everything was new, there might be more behind it
+        request(m_requested * 2);
+        return;
+    }
+
+    if (m_pending.isEmpty()) {
+        finishSync();
+        return;
+    }
+
+    m_commitWatcher->setFuture(QtConcurrent::run(&HistoryStore::writeEntries, m_fileName, m_pending));
+    m_pending.clear();
+}
+
+void HistoryStore::opened()
+{
+    const qint64 newest = m_openWatcher->result();
+    if (newest < 0) {
+        m_failed = true;
+        emit synced();
+        return;
+    }
+
+    // SQLite in WAL mode lets us read while the worker writes
+    m_db = QSqlDatabase::addDatabase(QLatin1String("QSQLITE"), m_connectionName);
+    m_db.setDatabaseName(m_fileName);
+    if (!m_db.open()) {
+        qCWarning(APPER) << "Failed to open history store" << m_fileName << m_db.lastError().text();
+        m_db = QSqlDatabase();
+        QSqlDatabase::removeDatabase(m_connectionName);
+        m_failed = true;
+        emit synced();
+        return;
+    }
+
+    m_newest = newest;
+    m_ready = true;
+    if (m_syncAgain) {
+        m_syncAgain = false;
+        sync();
+    }
+}
+
+void HistoryStore::committed()
+{
+    m_newest = qMax(m_newest, m_commitWatcher->result());
+    finishSync();
+}
+
+void HistoryStore::finishSync()
+{
+    emit synced();
+
+    if (m_syncAgain) {
+        m_syncAgain = false;
+        sync();
+    }
+}
+
+qint64 HistoryStore::openStore(const QString &fileName)
+{
+    QDir().mkpath(QFileInfo(fileName).absolutePath());
+
+    qint64 newest = -1;
+    const QString connectionName = QLatin1String("apper-history-open-") + QString::number(reinterpret_cast<quintptr>(QThread::currentThreadId()), 16);
+    {
+        QSqlDatabase db = QSqlDatabase::addDatabase(QLatin1String("QSQLITE"), connectionName);
+        db.setDatabaseName(fileName);
+        if (!db.open()) {
+            qCWarning(APPER) << "Failed to open history store" << fileName << db.lastError().text();
+        } else if (createSchema(db)) {
+            QSqlQuery query(QLatin1String("SELECT MAX(timespec) FROM transactions"), db);
+            newest = query.next() ? query.value(0).toLongLong() : 0;
+        }
+    }
+    QSqlDatabase::removeDatabase(connectionName);
+    return newest;
+}
+
+bool HistoryStore::createSchema(QSqlDatabase &db)
+{
+    QSqlQuery query(db);
+    query.exec(QLatin1String("PRAGMA journal_mode = WAL"));
+    query.exec(QLatin1String("PRAGMA synchronous = NORMAL"));
+
+    int version = 0;
+    if (query.exec(QLatin1String("PRAGMA user_version")) && query.next()) {
+        version = query.value(0).toInt();
+    }
+    if (version == STORE_VERSION) {
+        return true;
+    }
+
+    const QStringList statements = {
+        QLatin1String("DROP TABLE IF EXISTS packages"),
+        QLatin1String("DROP TABLE IF EXISTS transactions"),
+        QLatin1String("CREATE TABLE transactions ("
+                      "tid TEXT PRIMARY KEY, timespec INTEGER NOT NULL, role INTEGER NOT NULL, "
+                      "uid INTEGER NOT NULL, cmdline TEXT, data TEXT)"),
+        QLatin1String("CREATE INDEX transactions_timespec ON transactions (timespec)"),
+        QLatin1String("CREATE INDEX transactions_role ON transactions (role, timespec)"),
+        QLatin1String("CREATE INDEX transactions_uid ON transactions (uid, timespec)"),
+        // timespec is repeated here so a package history is read from the index
+        QLatin1String("CREATE TABLE packages ("
+                      "tid TEXT NOT NULL, name TEXT NOT NULL COLLATE NOCASE, info INTEGER NOT NULL, "
+                      "package_id TEXT NOT NULL, timespec INTEGER NOT NULL, "
+                      "UNIQUE (tid, package_id, info))"),
+        QLatin1String("CREATE INDEX packages_name ON packages (name, timespec)"),
+        QLatin1String("PRAGMA user_version = ") + QString::number(STORE_VERSION)
+    };
+
+    db.transaction();
+    for (const QString &statement : statements) {
+        if (!query.exec(statement)) {
+            qCWarning(APPER) << "Failed to create history store" << query.lastError().text();
+            db.rollback();
+            return false;
+        }
+    }
+    return db.commit();
+}
+
+void HistoryStore::request(uint count)
+{
+    m_pending.clear();
+    m_requested = count;
+    m_received = 0;
+    m_reachedKnown = false;
+    m_transaction = Daemon::getOldTransactions(count);
+    connect(m_transaction, &Transaction::transaction, this, &HistoryStore::transaction);
+    connect(m_transaction, &Transaction::finished, this, &HistoryStore::requestFinished);
+}
+
+qint64 HistoryStore::writeEntries(const QString &fileName, const QVector<Entry> &entries)
+{
+    qint64 newest = 0;
+    const QString connectionName = QLatin1String("apper-history-commit-") + QString::number(reinterpret_cast<quintptr>(QThread::currentThreadId()), 16);
+    {
+        QSqlDatabase db = QSqlDatabase::addDatabase(QLatin1String("QSQLITE"), connectionName);
+        db.setDatabaseName(fileName);
+        if (db.open()) {
+            newest = commit(db, entries);
+        } else {
+            qCWarning(APPER) << "Failed to open history store" << fileName << db.lastError().text();
+        }
+    }
+    QSqlDatabase::removeDatabase(connectionName);
+    return newest;
+}
+
+qint64 HistoryStore::commit(QSqlDatabase &db, const QVector<Entry> &entries)
+{
+    qint64 newest = 0;
+    db.transaction();
+
+    QSqlQuery transactionQuery(db);
+    transactionQuery.prepare(QLatin1String("INSERT OR IGNORE INTO transactions "
+                                           "(tid, timespec, role, uid, cmdline, data) VALUES (?, ?, ?, ?, ?, ?)"));
+    QSqlQuery packageQuery(db);
+    packageQuery.prepare(QLatin1String("INSERT OR IGNORE INTO packages "
+                                       "(tid, name, info, package_id, timespec) VALUES (?, ?, ?, ?, ?)"));
+
+    for (const Entry &entry : entries) {
+        const qint64 timespec = entry.timespec.toMSecsSinceEpoch();
+        transactionQuery.addBindValue(entry.tid);
+        transactionQuery.addBindValue(timespec);
+        transactionQuery.addBindValue(static_cast<int>(entry.role));
+        transactionQuery.addBindValue(entry.uid);
+        transactionQuery.addBindValue(entry.cmdline);
+        transactionQuery.addBindValue(entry.data);
+        if (!transactionQuery.exec()) {
+            qCWarning(APPER) << "Failed to store transaction" << entry.tid << transactionQuery.lastError().text();
+            continue;
+        }
+
+        // Each line looks like "installing\tname;version;arch;repo"
+        for (const QStringRef &line : entry.data.splitRef(QLatin1Char('\n'))) {
+            const int tab = line.indexOf(QLatin1Char('\t'));
+            if (tab == -1) {
+                continue;
+            }
+
+            const QString packageID = line.mid(tab + 1).toString();
+            packageQuery.addBindValue(entry.tid);
+            packageQuery.addBindValue(Transaction::packageName(packageID));
+            packageQuery.addBindValue(Daemon::enumFromString<Transaction>(line.left(tab).toString(), "Info"));
+            packageQuery.addBindValue(packageID);
+            packageQuery.addBindValue(timespec);
+            packageQuery.exec();
+        }
+        newest = qMax(newest, timespec);
+    }
+
+    if (!db.commit()) {
+        qCWarning(APPER) << "Failed to commit history store" << db.lastError().text();
+        return 0;
+    }
+    return newest;
+}
+
+#include "moc_HistoryStore.cpp"
@@ -0,0 +1,125 @@
+/***************************************************************************
+ *   Copyright (C) 2026 by agent                                           *
+ *   agent@local                                                           *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; see the file COPYING. If not, write to       *
+ *   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,  *
+ *   Boston, MA 02110-1301, USA.                                           *
+ ***************************************************************************/
+
+#ifndef HISTORY_STORE_H
+#define HISTORY_STORE_H
+
+#include <QObject>
+#include <QDateTime>
+#include <QSqlDatabase>
+#include <QVector>
+#include <QFutureWatcher>
+
+#include <Transaction>
+
+/**
+ * Local SQLite mirror of the PackageKit transaction history.
+ *
+ * PackageKit can only hand out its N newest transactions, so the
+ * store keeps a copy indexed by package name, date, role and user,
+ * and on sync() asks only for what is newer than what it has.
+ */
+class HistoryStore : public QObject
+{
+    Q_OBJECT
+public:
+    struct Entry {
+        QString tid;
+        QDateTime timespec;
+        PackageKit::Transaction::Role role = PackageKit::Transaction::RoleUnknown;
+        uint uid = 0;
+        QString cmdline;
+        QString data;
+    };
+    struct PackageEvent {
+        QDateTime timespec;
+        PackageKit::Transaction::Info info = PackageKit::Transaction::InfoUnknown;
+        QString packageID;
+        uint uid = 0;
+        QString cmdline;
+    };
+
+    static HistoryStore* instance();
+
+    explicit HistoryStore(const QString &fileName, QObject *parent = nullptr);
+    ~HistoryStore() override;
+
+    /**
+     * False once opening the store failed
+     */
+    bool isValid() const;
+    /**
+     * The store is opened in the background, until then
+     * queries return nothing
+     */
+    bool isReady() const;
+    bool isSyncing() const;
+
+    /**
+     * Copies the transactions PackageKit has that are newer
+     * than the newest stored one, emits synced() when done
+     */
+    void sync();
+
+    /**
+     * Transactions newest first, if search is not empty only the ones
+     * touching a package starting with it or run by a matching command
+     */
+    QVector<Entry> transactions(int offset, int limit, const QString &search = QString()) const;
+
+    /**
+     * What happened to packageName, newest first
+     */
+    QVector<PackageEvent> packageHistory(const QString &packageName, int limit = 1) const;
+
+Q_SIGNALS:
+    void synced();
+
+private Q_SLOTS:
+    void transaction(PackageKit::Transaction *trans);
+    void requestFinished();
+    void opened();
+    void committed();
+
+private:
+    static qint64 openStore(const QString &fileName);
+    static bool createSchema(QSqlDatabase &db);
+    static qint64 writeEntries(const QString &fileName, const QVector<Entry> &entries);
+    static qint64 commit(QSqlDatabase &db, const QVector<Entry> &entries);
+    void request(uint count);
+    void finishSync();
+
+    QString m_fileName;
+    QString m_connectionName;
+    QSqlDatabase m_db;
+    bool m_ready = false;
+    bool m_failed = false;
+    QFutureWatcher<qint64> *m_openWatcher;
+    QFutureWatcher<qint64> *m_commitWatcher;
+    qint64 m_newest = 0;
+    QVector<Entry> m_pending;
+    uint m_requested = 0;
+    uint m_received = 0;
+    bool m_reachedKnown = false;
+    bool m_syncAgain = false;
+    PackageKit::Transaction *m_transaction = nullptr;
+};
+
+#endif // HISTORY_STORE_H
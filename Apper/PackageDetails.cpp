@@ -22,8 +22,11 @@
 #include "ui_PackageDetails.h"
 
 #include "ScreenShotViewer.h"
+#include "ScreenshotCache.h"
+#include "HistoryStore.h"
 
 #include <PackageModel.h>
+#include <DependencyGraph.h>
 #include <PkStrings.h>
 #include <PkIcons.h>
 
@@ -34,7 +37,6 @@
 #include <KService>
 #include <KServiceGroup>
 #include <KDesktopFile>
-#include <QTemporaryFile>
 #include <KPixmapSequence>
 #include <QTextDocument>
 #include <QPlainTextEdit>
@@ -42,9 +44,10 @@
 #include <QPainter>
 #include <QAbstractAnimation>
 #include <QStringBuilder>
+#include <QSharedPointer>
 
 #include <KFormat>
-#include <KIO/Job>
+#include <KUser>
 #include <QMenu>
 #include <QDir>
 
@@ -63,6 +66,7 @@
 
 #define BLUR_RADIUS 15
 #define FINAL_HEIGHT 210
+#define PACKAGE_CACHE_SIZE 64
 
 using namespace PackageKit;
 
@@ -150,6 +154,10 @@ PackageDetails::PackageDetails(QWidget *parent)
     ui->requiredByLV->header()->hideSection(PackageModel::OriginCol);
     ui->requiredByLV->header()->hideSection(PackageModel::SizeCol);
 
+    m_removalImpact = new DependencyGraph(this);
+    connect(m_removalImpact, &DependencyGraph::levelFinished, this, &PackageDetails::removalImpactChanged);
+    connect(m_removalImpact, &DependencyGraph::finished, this, &PackageDetails::removalImpactChanged);
+
     fileListAction = menu->addAction(i18n("File List"));
     fileListAction->setCheckable(true);
     fileListAction->setData(PackageKit::Transaction::RoleGetFiles);
@@ -185,6 +193,13 @@ PackageDetails::PackageDetails(QWidget *parent)
     m_fadeStacked->setEndValue(qreal(1));
     connect(m_fadeStacked, SIGNAL(finished()), this, SLOT(display()));
 
+    connect(ScreenshotCache::instance(), &ScreenshotCache::ready, this, &PackageDetails::screenshotReady);
+
+    // PackageKit emits updatesChanged() whenever the package database
+    // changes, any cached dependency list might be outdated then
+    m_cache.setMaxCost(PACKAGE_CACHE_SIZE);
+    connect(Daemon::global(), &Daemon::updatesChanged, this, &PackageDetails::clearCache);
+
     // It's is impossible due to some limitation in Qt to set two effects on the same
     // Widget
     m_fadeScreenshot = new QPropertyAnimation(effect, "opacity", this);
@@ -293,26 +308,19 @@ void PackageDetails::setPackage(const QModelIndex &index)
     m_hasFileList = false;
     m_hasRequires = false;
     m_hasDepends  = false;
+    m_removalImpact->cancel();
+    ui->removalImpactL->clear();
     qCDebug(APPER) << "appId" << appId << "m_package" << m_packageID;
 
     QString pkgIconPath = index.data(PackageModel::IconRole).toString();
     m_currentIcon       = PkIcons::getIcon(pkgIconPath, QString()).pixmap(64, 64);
     m_appName           = index.data(PackageModel::NameRole).toString();
 
+    m_screenshotPath.clear();
     m_currentScreenshot = thumbnail(Transaction::packageName(m_packageID));
     qCDebug(APPER) << "current thumbnail" << m_currentScreenshot;
     if (!m_currentScreenshot.isEmpty()) {
-        if (m_screenshotPath.contains(m_currentScreenshot)) {
-            display();
-        } else {
-            auto tempFile = new QTemporaryFile(QDir::tempPath() + QLatin1String("/apper.XXXXXX.png"));
-            tempFile->open();
-            KIO::FileCopyJob *job = KIO::file_copy(m_currentScreenshot,
-                                                   QUrl::fromLocalFile(tempFile->fileName()),
-                                                   -1,
-                                                   KIO::Overwrite | KIO::HideProgressInfo);
-            connect(job, &KIO::FileCopyJob::result, this, &PackageDetails::resultJob);
-        }
+        ScreenshotCache::instance()->fetch(m_currentScreenshot);
     }
 
     if (m_actionGroup->checkedAction()) {
@@ -324,7 +332,7 @@ void PackageDetails::on_screenshotL_clicked()
 {
     const QUrl url = screenshot(Transaction::packageName(m_packageID));
     if (!url.isEmpty()) {
-        auto view = new ScreenShotViewer(url);
+        auto view = new ScreenShotViewer(url, m_currentScreenshot);
         view->setWindowTitle(m_appName);
         view->show();
     }
@@ -365,8 +373,12 @@ void PackageDetails::actionActivated(QAction *action)
 
     // Check to see if we don't already have the required data
     uint role = action->data().toUInt();
+    const CachedPackage *cached = m_cache.object(m_packageID);
     switch (role) {
     case PackageKit::Transaction::RoleGetDetails:
+        if (!m_hasDetails && cached && cached->hasDetails) {
+            description(cached->details);
+        }
         if (m_hasDetails) {
             description(m_details);
             display();
@@ -374,18 +386,31 @@ void PackageDetails::actionActivated(QAction *action)
         }
         break;
     case PackageKit::Transaction::RoleDependsOn:
+        if (!m_hasDepends && cached && cached->hasDepends) {
+            restoreDependencies(cached->depends, m_dependsModel);
+            m_hasDepends = true;
+        }
         if (m_hasDepends) {
             display();
             return;
         }
         break;
     case PackageKit::Transaction::RoleRequiredBy:
+        queryRemovalImpact();
+        if (!m_hasRequires && cached && cached->hasRequires) {
+            restoreDependencies(cached->requiredBy, m_requiresModel);
+            m_hasRequires = true;
+        }
         if (m_hasRequires) {
             display();
             return;
         }
         break;
     case PackageKit::Transaction::RoleGetFiles:
+        if (!m_hasFileList && cached && cached->hasFileList) {
+            m_currentFileList = cached->files;
+            m_hasFileList = true;
+        }
         if (m_hasFileList) {
             display();
             return;
@@ -404,6 +429,7 @@ void PackageDetails::actionActivated(QAction *action)
     case PackageKit::Transaction::RoleDependsOn:
         m_dependsModel->clear();
         m_transaction = Daemon::dependsOn(m_packageID, PackageKit::Transaction::FilterNone, false);
+        cacheDependencies(m_transaction, PackageKit::Transaction::RoleDependsOn);
         connect(m_transaction, SIGNAL(package(PackageKit::Transaction::Info,QString,QString)),
                 m_dependsModel, SLOT(addPackage(PackageKit::Transaction::Info,QString,QString)));
         connect(m_transaction, SIGNAL(finished(PackageKit::Transaction::Exit,uint)),
@@ -412,6 +438,7 @@ void PackageDetails::actionActivated(QAction *action)
     case PackageKit::Transaction::RoleRequiredBy:
         m_requiresModel->clear();
         m_transaction = Daemon::requiredBy(m_packageID, PackageKit::Transaction::FilterNone, false);
+        cacheDependencies(m_transaction, PackageKit::Transaction::RoleRequiredBy);
         connect(m_transaction, SIGNAL(package(PackageKit::Transaction::Info,QString,QString)),
                 m_requiresModel, SLOT(addPackage(PackageKit::Transaction::Info,QString,QString)));
         connect(m_transaction, SIGNAL(finished(PackageKit::Transaction::Exit,uint)),
@@ -434,11 +461,10 @@ void PackageDetails::actionActivated(QAction *action)
     m_busySeq->start();
 }
 
-void PackageDetails::resultJob(KJob *job)
+void PackageDetails::screenshotReady(const QUrl &url, const QString &fileName)
 {
-    KIO::FileCopyJob *fJob = qobject_cast<KIO::FileCopyJob*>(job);
-    if (!fJob->error()) {
-        m_screenshotPath[fJob->srcUrl()] = fJob->destUrl().toLocalFile();
+    if (url == m_currentScreenshot) {
+        m_screenshotPath = fileName;
         display();
     }
 }
@@ -480,6 +506,43 @@ void PackageDetails::fadeOut(FadeWidgets widgets)
     }
 }
 
+void PackageDetails::queryRemovalImpact()
+{
+    // Only an installed package can be removed
+    if (!Transaction::packageData(m_packageID).startsWith(QLatin1String("installed"))) {
+        ui->removalImpactL->hide();
+        return;
+    }
+
+    ui->removalImpactL->show();
+    if (m_removalImpact->isRunning() || !ui->removalImpactL->text().isEmpty()) {
+        // Already asked for this package
+        return;
+    }
+
+    // Follows what needs it until nothing else does, the
+    // graph remembers closures it already walked
+    ui->removalImpactL->setText(i18n("Calculating what removing this package would remove..."));
+    m_removalImpact->query(m_packageID, DependencyGraph::RequiredBy);
+}
+
+void PackageDetails::removalImpactChanged()
+{
+    const int count = m_removalImpact->closure().size();
+    const QString size = KFormat().formatByteSize(m_removalImpact->installedSize());
+    if (m_removalImpact->isRunning()) {
+        ui->removalImpactL->setText(i18np("Removing this package would also remove at least one package and free at least %2...",
+                                          "Removing this package would also remove at least %1 packages and free at least %2...",
+                                          count, size));
+    } else if (count) {
+        ui->removalImpactL->setText(i18np("Removing this package would also remove one package that needs it and free about %2.",
+                                          "Removing this package would also remove %1 packages that need it and free about %2.",
+                                          count, size));
+    } else {
+        ui->removalImpactL->setText(i18n("Nothing else needs this package, removing it would free about %1.", size));
+    }
+}
+
 void PackageDetails::display()
 {
     // If we shouldn't be showing hide the pannel
@@ -546,10 +609,10 @@ void PackageDetails::display()
         // transparent, and make sure the details are going
         // to be shown
         if (m_fadeScreenshot->currentValue().toReal() == 0 &&
-            m_screenshotPath.contains(m_currentScreenshot) &&
+            !m_screenshotPath.isEmpty() &&
             m_fadeStacked->direction() == QAbstractAnimation::Forward) {
             QPixmap pixmap;
-            pixmap = QPixmap(m_screenshotPath[m_currentScreenshot])
+            pixmap = QPixmap(m_screenshotPath)
                              .scaled(160,120, Qt::KeepAspectRatio, Qt::SmoothTransformation);
             ui->screenshotL->setPixmap(pixmap);
             ui->screenshotL->setCursor(Qt::PointingHandCursor);
@@ -656,6 +719,29 @@ void PackageDetails::setupDescription()
         ui->sizeL->hide();
     }
 
+    const QVector<HistoryStore::PackageEvent> history = HistoryStore::instance()->packageHistory(Transaction::packageName(m_packageID));
+    if (history.isEmpty()) {
+        ui->historyL->hide();
+    } else {
+        const HistoryStore::PackageEvent &event = history.first();
+        const QString date = QLocale::system().toString(event.timespec, QLocale::ShortFormat);
+        const QString user = KUser(event.uid).loginName();
+        switch (event.info) {
+        case Transaction::InfoInstalling:
+            ui->historyL->setText(i18nc("%1 is a date, %2 a user name", "Installed on %1 by %2", date, user));
+            break;
+        case Transaction::InfoRemoving:
+            ui->historyL->setText(i18nc("%1 is a date, %2 a user name", "Removed on %1 by %2", date, user));
+            break;
+        case Transaction::InfoUpdating:
+            ui->historyL->setText(i18nc("%1 is a date, %2 a user name", "Updated on %1 by %2", date, user));
+            break;
+        default:
+            ui->historyL->setText(i18nc("%1 is a date, %2 a user name", "Last changed on %1 by %2", date, user));
+        }
+        ui->historyL->show();
+    }
+
     if (m_currentIcon.isNull()) {
         ui->iconL->clear();
     } else {
@@ -748,6 +834,10 @@ QUrl PackageDetails::screenshot(const QString &pkgName) const
 void PackageDetails::description(const PackageKit::Details &details)
 {
     qCDebug(APPER) << details;
+    CachedPackage *cached = cachedPackage(details.packageId());
+    cached->details = details;
+    cached->hasDetails = true;
+
     m_details = details;
     m_detailsDescription = details.description();
     m_hasDetails = true;
@@ -757,10 +847,10 @@ void PackageDetails::description(const PackageKit::Details &details)
     // FIXME: The whole AppStream handling sucks badly, since it was added later
     // and on to of the package-based model. So we can't respect the "multiple apps
     // in one package" case here.
-    const QList<AppStream::Component> apps = AppStreamHelper::instance()->applications(Transaction::packageName(m_packageID));
-    for (const AppStream::Component &app : apps) {
-        if (!app.description().isEmpty()) {
-            m_detailsDescription = app.description();
+    const QList<AppStreamHelper::Application> apps = AppStreamHelper::instance()->applications(Transaction::packageName(m_packageID));
+    for (const AppStreamHelper::Application &app : apps) {
+        if (!app.description.isEmpty()) {
+            m_detailsDescription = app.description;
             break;
         }
     }
@@ -774,6 +864,9 @@ void PackageDetails::finished()
     }
     m_transaction = nullptr;
 
+    // What the user asked for is done, the neighbours can go now
+    startPrefetch();
+
     auto transaction = qobject_cast<PackageKit::Transaction*>(sender());
     qCDebug(APPER);
     if (transaction) {
@@ -796,8 +889,111 @@ void PackageDetails::finished()
 
 void PackageDetails::files(const QString &packageID, const QStringList &files)
 {
-    Q_UNUSED(packageID)
+    CachedPackage *cached = cachedPackage(packageID);
+    cached->files = files;
+    cached->hasFileList = true;
+
     m_currentFileList = files;
 }
 
+void PackageDetails::prefetchDetails(const QStringList &packageIDs)
+{
+    if (!descriptionAction->isEnabled()) {
+        return;
+    }
+
+    // Only the last selection matters, and it must not get queued
+    // ahead of the transaction fetching the selected package
+    m_prefetchQueue = packageIDs;
+    if (!m_transaction) {
+        startPrefetch();
+    }
+}
+
+void PackageDetails::startPrefetch()
+{
+    const QStringList packageIDs = m_prefetchQueue;
+    m_prefetchQueue.clear();
+
+    QStringList missing;
+    for (const QString &packageID : packageIDs) {
+        const CachedPackage *cached = m_cache.object(packageID);
+        if (packageID != m_packageID && !m_prefetching.contains(packageID) &&
+                !(cached && cached->hasDetails)) {
+            missing << packageID;
+        }
+    }
+
+    if (missing.isEmpty()) {
+        return;
+    }
+
+    qCDebug(APPER) << "Prefetching details of" << missing;
+    m_prefetching.unite(missing.toSet());
+    Transaction *transaction = Daemon::getDetails(missing);
+    connect(transaction, &Transaction::details, this, [this] (const PackageKit::Details &details) {
+        CachedPackage *cached = cachedPackage(details.packageId());
+        cached->details = details;
+        cached->hasDetails = true;
+    });
+    connect(transaction, &Transaction::finished, this, [this, missing] {
+        for (const QString &packageID : missing) {
+            m_prefetching.remove(packageID);
+        }
+    });
+}
+
+void PackageDetails::clearCache()
+{
+    m_cache.clear();
+}
+
+PackageDetails::CachedPackage* PackageDetails::cachedPackage(const QString &packageID)
+{
+    CachedPackage *cached = m_cache.object(packageID);
+    if (!cached) {
+        cached = new CachedPackage;
+        m_cache.insert(packageID, cached);
+    }
+    return cached;
+}
+
+void PackageDetails::cacheDependencies(Transaction *transaction, Transaction::Role role)
+{
+    // The list is only stored once complete, so it doesn't matter
+    // if the user moves on to another package meanwhile
+    const QString packageID = m_packageID;
+    auto packages = QSharedPointer<QVector<CachedDependency> >::create();
+    connect(transaction, &Transaction::package, this, [packages] (Transaction::Info info, const QString &pkgID, const QString &summary) {
+        CachedDependency dependency;
+        dependency.info = info;
+        dependency.packageID = pkgID;
+        dependency.summary = summary;
+        packages->append(dependency);
+    });
+    connect(transaction, &Transaction::finished, this, [this, packageID, packages, role] (Transaction::Exit status) {
+        if (status != Transaction::ExitSuccess) {
+            return;
+        }
+
+        CachedPackage *cached = cachedPackage(packageID);
+        if (role == Transaction::RoleDependsOn) {
+            cached->depends = *packages;
+            cached->hasDepends = true;
+        } else {
+            cached->requiredBy = *packages;
+            cached->hasRequires = true;
+        }
+    });
+}
+
+void PackageDetails::restoreDependencies(const QVector<CachedDependency> &packages, PackageModel *model)
+{
+    model->clear();
+    for (const CachedDependency &dependency : packages) {
+        model->addPackage(dependency.info, dependency.packageID, dependency.summary);
+    }
+    model->finished();
+}
+
 #include "moc_PackageDetails.cpp"
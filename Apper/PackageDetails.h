@@ -25,9 +25,10 @@
 #include <Details>
 
 #include <KPixmapSequenceOverlayPainter>
-#include <KJob>
 
 #include <QUrl>
+#include <QCache>
+#include <QSet>
 #include <QWidget>
 #include <QSortFilterProxyModel>
 #include <QPropertyAnimation>
@@ -39,6 +40,7 @@ namespace Ui {
 }
 
 class PackageModel;
+class DependencyGraph;
 class PackageDetails : public QWidget
 {
     Q_OBJECT
@@ -58,6 +60,12 @@ public:
     void hidePackageVersion(bool hide);
     void hidePackageArch(bool hide);
 
+    /**
+     * Fetches the details of packageIDs in a single transaction,
+     * so they show up at once when the user selects them
+     */
+    void prefetchDetails(const QStringList &packageIDs);
+
 public Q_SLOTS:
     void hide();
 
@@ -70,11 +78,34 @@ private Q_SLOTS:
     void description(const PackageKit::Details &details);
     void files(const QString &packageID, const QStringList &files);
     void finished();
-    void resultJob(KJob *);
+    void screenshotReady(const QUrl &url, const QString &fileName);
+    void clearCache();
+    void removalImpactChanged();
 
     void display();
 
 private:
+    struct CachedDependency {
+        PackageKit::Transaction::Info info;
+        QString packageID;
+        QString summary;
+    };
+    struct CachedPackage {
+        bool hasDetails = false;
+        PackageKit::Details details;
+        bool hasDepends = false;
+        QVector<CachedDependency> depends;
+        bool hasRequires = false;
+        QVector<CachedDependency> requiredBy;
+        bool hasFileList = false;
+        QStringList files;
+    };
+
+    CachedPackage* cachedPackage(const QString &packageID);
+    void startPrefetch();
+    void cacheDependencies(PackageKit::Transaction *transaction, PackageKit::Transaction::Role role);
+    void restoreDependencies(const QVector<CachedDependency> &packages, PackageModel *model);
+    void queryRemovalImpact();
     void fadeOut(FadeWidgets widgets);
     void setupDescription();
     QVector<QPair<QString, QString> > locateApplication(const QString &_relPath, const QString &menuId) const;
@@ -127,10 +158,18 @@ private:
     bool m_hasRequires;
     PackageModel *m_requiresModel;
     QSortFilterProxyModel *m_requiresProxy;
+    // What removing an installed package takes with it
+    DependencyGraph *m_removalImpact;
+
+    // What was fetched for the last packages, so going back to
+    // one of them or switching tabs doesn't ask PackageKit again
+    QCache<QString, CachedPackage> m_cache;
+    QSet<QString> m_prefetching;
+    QStringList m_prefetchQueue;
 
     // Screen shot buffer
     QUrl      m_currentScreenshot;
-    QHash<QUrl, QString> m_screenshotPath;
+    QString   m_screenshotPath;
 };
 
 Q_DECLARE_OPERATORS_FOR_FLAGS(PackageDetails::FadeWidgets)
@@ -19,23 +19,26 @@
  ***************************************************************************/
 
 #include "ScreenShotViewer.h"
+#include "ScreenshotCache.h"
 
 #include <QIcon>
-#include <QDir>
 #include <QParallelAnimationGroup>
 #include <QPropertyAnimation>
 #include <QGraphicsOpacityEffect>
-#include <QTemporaryFile>
+#include <QGuiApplication>
+#include <QImageReader>
+#include <QScreen>
+#include <QtConcurrentRun>
 #include <KPixmapSequence>
-#include <KIO/Job>
 
 #include <KIconLoader>
 #include <KLocalizedString>
 
 #include "ClickableLabel.h"
 
-ScreenShotViewer::ScreenShotViewer(const QUrl &url, QWidget *parent)
- : QScrollArea(parent)
+ScreenShotViewer::ScreenShotViewer(const QUrl &url, const QUrl &thumbnail, QWidget *parent)
+ : QScrollArea(parent),
+   m_url(url)
 {
     m_screenshotL = new ClickableLabel(this);
     m_screenshotL->setCursor(Qt::PointingHandCursor);
@@ -49,43 +52,78 @@ ScreenShotViewer::ScreenShotViewer(const QUrl &url, QWidget *parent)
     setWidget(m_screenshotL);
     setWindowIcon(QIcon::fromTheme(QLatin1String("layer-visible-on")));
 
-    auto tempFile = new QTemporaryFile(QDir::tempPath() + QLatin1String("/apper.XXXXXX.png"));
-    tempFile->open();
-    KIO::FileCopyJob *job = KIO::file_copy(url,
-                                           QUrl::fromLocalFile(tempFile->fileName()),
-                                           -1,
-                                           KIO::Overwrite | KIO::HideProgressInfo);
-    connect(job, &KIO::FileCopyJob::result, this, &ScreenShotViewer::resultJob);
-
     m_busySeq = new KPixmapSequenceOverlayPainter(this);
     m_busySeq->setSequence(KIconLoader::global()->loadPixmapSequence(QLatin1String("process-working"), KIconLoader::SizeSmallMedium));
     m_busySeq->setAlignment(Qt::AlignHCenter | Qt::AlignVCenter);
     m_busySeq->setWidget(m_screenshotL);
     m_busySeq->start();
 
+    // Show the thumbnail while the real screenshot loads
+    const QString preview = ScreenshotCache::instance()->fileName(thumbnail);
+    if (!preview.isEmpty()) {
+        m_screenshotL->setAlignment(Qt::AlignCenter);
+        m_screenshotL->setPixmap(QPixmap(preview));
+    }
+
     connect(m_screenshotL, SIGNAL(clicked()), this, SLOT(deleteLater()));
+
+    m_watcher = new QFutureWatcher<QImage>(this);
+    connect(m_watcher, &QFutureWatcher<QImage>::finished, this, &ScreenShotViewer::decodeFinished);
+
+    ScreenshotCache *cache = ScreenshotCache::instance();
+    connect(cache, &ScreenshotCache::ready, this, &ScreenShotViewer::screenshotReady);
+    connect(cache, &ScreenshotCache::failed, this, &ScreenShotViewer::screenshotFailed);
+    cache->fetch(url);
 }
 
 ScreenShotViewer::~ScreenShotViewer()
 {
 }
 
-void ScreenShotViewer::resultJob(KJob *job)
+void ScreenShotViewer::screenshotReady(const QUrl &url, const QString &fileName)
+{
+    if (url != m_url) {
+        return;
+    }
+
+    // Screenshots are often much bigger than the screen, decode
+    // them already scaled and away from the GUI thread
+    const QSize maxSize = QGuiApplication::primaryScreen()->availableSize();
+    m_watcher->setFuture(QtConcurrent::run(&ScreenShotViewer::decode, fileName, maxSize));
+}
+
+void ScreenShotViewer::decodeFinished()
 {
     m_busySeq->stop();
-    auto fJob = qobject_cast<KIO::FileCopyJob*>(job);
-    if (!fJob->error()) {
-        m_screenshot = QPixmap(fJob->destUrl().toLocalFile());
-
-        QPropertyAnimation *anim1 = new QPropertyAnimation(this, "size");
-        anim1->setDuration(500);
-        anim1->setStartValue(size());
-        anim1->setEndValue(m_screenshot.size());
-        anim1->setEasingCurve(QEasingCurve::OutCubic);
-
-        connect(anim1, &QPropertyAnimation::finished, this, &ScreenShotViewer::fadeIn);
-        anim1->start();
-    } else {
+    const QImage image = m_watcher->result();
+    if (image.isNull()) {
+        m_screenshotL->setText(i18n("Could not find screen shot."));
+        return;
+    }
+
+    const bool shown = !m_screenshot.isNull();
+    m_screenshot = QPixmap::fromImage(image);
+    if (shown) {
+        // The cached copy was outdated, just swap it
+        m_screenshotL->setPixmap(m_screenshot);
+        m_screenshotL->adjustSize();
+        return;
+    }
+
+    QPropertyAnimation *anim1 = new QPropertyAnimation(this, "size");
+    anim1->setDuration(500);
+    anim1->setStartValue(size());
+    anim1->setEndValue(m_screenshot.size());
+    anim1->setEasingCurve(QEasingCurve::OutCubic);
+
+    connect(anim1, &QPropertyAnimation::finished, this, &ScreenShotViewer::fadeIn);
+    anim1->start();
+}
+
+void ScreenShotViewer::screenshotFailed(const QUrl &url)
+{
+    if (url == m_url) {
+        m_busySeq->stop();
         m_screenshotL->setText(i18n("Could not find screen shot."));
     }
 }
@@ -105,4 +143,14 @@ void ScreenShotViewer::fadeIn()
     anim->start();
 }
 
+QImage ScreenShotViewer::decode(const QString &fileName, const QSize &maxSize)
+{
+    QImageReader reader(fileName);
+    const QSize size = reader.size();
+    if (size.isValid() && (size.width() > maxSize.width() || size.height() > maxSize.height())) {
+        reader.setScaledSize(size.scaled(maxSize, Qt::KeepAspectRatio));
+    }
+    return reader.read();
+}
+
 #include "moc_ScreenShotViewer.cpp"
@@ -23,25 +23,37 @@
 
 
 #include <KPixmapSequenceOverlayPainter>
-#include <KJob>
 
 #include <QScrollArea>
 #include <QPixmap>
+#include <QImage>
+#include <QUrl>
+#include <QFutureWatcher>
 
 class ClickableLabel;
 class ScreenShotViewer : public QScrollArea
 {
 Q_OBJECT
 public:
-    explicit ScreenShotViewer(const QUrl &url, QWidget *parent = nullptr);
+    /**
+     * Shows the screenshot at url, the already downloaded
+     * thumbnail is displayed while it loads
+     */
+    explicit ScreenShotViewer(const QUrl &url, const QUrl &thumbnail = QUrl(), QWidget *parent = nullptr);
     ~ScreenShotViewer() override;
 
 private Q_SLOTS:
-    void resultJob(KJob *);
+    void screenshotReady(const QUrl &url, const QString &fileName);
+    void screenshotFailed(const QUrl &url);
+    void decodeFinished();
     void fadeIn();
 
 private:
+    static QImage decode(const QString &fileName, const QSize &maxSize);
+
+    QFutureWatcher<QImage> *m_watcher;
     KPixmapSequenceOverlayPainter *m_busySeq;
+    QUrl            m_url;
     QPixmap         m_screenshot;
     ClickableLabel *m_screenshotL;
 };
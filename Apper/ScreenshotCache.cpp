@@ -0,0 +1,361 @@
+/***************************************************************************
+ *   Copyright (C) 2026 by agent                                           *
+ *   agent@local                                                           *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; see the file COPYING. If not, write to       *
+ *   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,  *
+ *   Boston, MA 02110-1301, USA.                                           *
+ ***************************************************************************/
+
+#include "ScreenshotCache.h"
+
+#include <KIO/StoredTransferJob>
+
+#include <QApplication>
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QTimer>
+
+#include <QLoggingCategory>
+
+#include <algorithm>
+
+// 50 MiB holds a few hundred screenshots
+#define CACHE_MAX_SIZE   (50 * 1024 * 1024)
+// Entries older than a day are revalidated
+#define CACHE_MAX_AGE    (24 * 60 * 60 * 1000)
+#define CACHE_PREFETCHES 2
+#define INDEX_MAGIC      0x41505353
+#define INDEX_VERSION    1
+
+Q_DECLARE_LOGGING_CATEGORY(APPER)
+
+ScreenshotCache* ScreenshotCache::instance()
+{
+    static ScreenshotCache *cache = nullptr;
+    if (!cache) {
+        const QString directory = QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation) + QLatin1String("/apper/screenshots");
+        cache = new ScreenshotCache(directory, CACHE_MAX_SIZE, qApp);
+    }
+    return cache;
+}
+
+ScreenshotCache::ScreenshotCache(const QString &directory, qint64 maxSize, QObject *parent)
+ : QObject(parent),
+   m_directory(directory),
+   m_maxSize(maxSize),
+   m_maxAge(CACHE_MAX_AGE)
+{
+    // Last used times change on every lookup, write them in batches
+    m_saveTimer = new QTimer(this);
+    m_saveTimer->setSingleShot(true);
+    m_saveTimer->setInterval(2000);
+    connect(m_saveTimer, &QTimer::timeout, this, &ScreenshotCache::saveIndex);
+
+    QDir().mkpath(m_directory);
+    loadIndex();
+}
+
+ScreenshotCache::~ScreenshotCache()
+{
+    if (m_saveTimer->isActive()) {
+        saveIndex();
+    }
+}
+
+QString ScreenshotCache::fileName(const QUrl &url)
+{
+    auto it = m_entries.find(key(url));
+    if (it == m_entries.end()) {
+        return QString();
+    }
+
+    touch(it.value());
+    return filePath(it.key());
+}
+
+void ScreenshotCache::fetch(const QUrl &url)
+{
+    if (url.isEmpty()) {
+        return;
+    }
+
+    // Asked for it directly, no need to keep it queued
+    m_queue.removeAll(url);
+
+    auto it = m_entries.find(key(url));
+    if (it != m_entries.end()) {
+        touch(it.value());
+        emit ready(url, filePath(it.key()));
+        if (QDateTime::currentMSecsSinceEpoch() - it.value().validated < m_maxAge) {
+            return;
+        }
+    }
+
+    start(url, false);
+}
+
+void ScreenshotCache::prefetch(const QList<QUrl> &urls)
+{
+    // Only what the user is looking at now matters
+    m_queue.clear();
+    for (const QUrl &url : urls) {
+        if (!url.isEmpty() && !m_entries.contains(key(url)) && !m_queue.contains(url)) {
+            m_queue << url;
+        }
+    }
+    startQueued();
+}
+
+bool ScreenshotCache::isFetching(const QUrl &url) const
+{
+    for (const Request &request : m_jobs) {
+        if (request.url == url) {
+            return true;
+        }
+    }
+    return false;
+}
+
+qint64 ScreenshotCache::size() const
+{
+    return m_size;
+}
+
+void ScreenshotCache::setMaxSize(qint64 maxSize)
+{
+    m_maxSize = maxSize;
+    evict(QString());
+}
+
+void ScreenshotCache::setMaxAge(qint64 maxAge)
+{
+    m_maxAge = maxAge;
+}
+
+void ScreenshotCache::jobFinished(KJob *job)
+{
+    const Request request = m_jobs.take(job);
+    if (request.prefetch) {
+        --m_prefetching;
+    }
+
+    const QString fileKey = key(request.url);
+    auto it = m_entries.find(fileKey);
+    auto tJob = static_cast<KIO::StoredTransferJob*>(job);
+    if (tJob->error()) {
+        qCDebug(APPER) << "Failed to download" << request.url << tJob->errorString();
+        // A stale copy was already handed out by fetch()
+        if (it == m_entries.end() && !request.prefetch) {
+            emit failed(request.url);
+        }
+        startQueued();
+        return;
+    }
+
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    if (it != m_entries.end() && tJob->queryMetaData(QLatin1String("responsecode")).toInt() == 304) {
+        // Not modified
+        it.value().validated = now;
+        m_saveTimer->start();
+        startQueued();
+        return;
+    }
+
+    QSaveFile file(filePath(fileKey));
+    if (!file.open(QIODevice::WriteOnly) || file.write(tJob->data()) != tJob->data().size() || !file.commit()) {
+        qCWarning(APPER) << "Failed to store screenshot" << file.fileName() << file.errorString();
+        if (it == m_entries.end() && !request.prefetch) {
+            emit failed(request.url);
+        }
+        startQueued();
+        return;
+    }
+
+    Entry entry;
+    const QStringList headers = tJob->queryMetaData(QLatin1String("HTTP-Headers")).split(QLatin1Char('\n'));
+    for (const QString &header : headers) {
+        const int colon = header.indexOf(QLatin1Char(':'));
+        if (colon == -1) {
+            continue;
+        }
+
+        const QStringRef name = header.leftRef(colon).trimmed();
+        if (name.compare(QLatin1String("ETag"), Qt::CaseInsensitive) == 0) {
+            entry.etag = header.mid(colon + 1).trimmed();
+        } else if (name.compare(QLatin1String("Last-Modified"), Qt::CaseInsensitive) == 0) {
+            entry.lastModified = header.mid(colon + 1).trimmed();
+        }
+    }
+    entry.size = tJob->data().size();
+    entry.lastUsed = now;
+    entry.validated = now;
+
+    if (it != m_entries.end()) {
+        m_size -= it.value().size;
+    }
+    m_size += entry.size;
+    m_entries[fileKey] = entry;
+    evict(fileKey);
+    m_saveTimer->start();
+
+    emit ready(request.url, file.fileName());
+    startQueued();
+}
+
+void ScreenshotCache::saveIndex()
+{
+    m_saveTimer->stop();
+
+    QSaveFile file(m_directory + QLatin1String("/index"));
+    if (!file.open(QIODevice::WriteOnly)) {
+        qCWarning(APPER) << "Failed to save screenshot cache index" << file.errorString();
+        return;
+    }
+
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_5_6);
+    stream << quint32(INDEX_MAGIC) << quint32(INDEX_VERSION) << quint32(m_entries.size());
+    for (auto it = m_entries.constBegin(); it != m_entries.constEnd(); ++it) {
+        const Entry &entry = it.value();
+        stream << it.key() << entry.etag << entry.lastModified
+               << entry.size << entry.lastUsed << entry.validated;
+    }
+    file.commit();
+}
+
+QString ScreenshotCache::key(const QUrl &url)
+{
+    return QString::fromLatin1(QCryptographicHash::hash(url.toEncoded(), QCryptographicHash::Sha1).toHex());
+}
+
+QString ScreenshotCache::filePath(const QString &key) const
+{
+    return m_directory + QLatin1Char('/') + key;
+}
+
+void ScreenshotCache::start(const QUrl &url, bool prefetch)
+{
+    if (isFetching(url)) {
+        return;
+    }
+
+    // We are the cache, don't let KIO answer from its own
+    KIO::StoredTransferJob *job = KIO::storedGet(url, KIO::Reload, KIO::HideProgressInfo);
+    job->addMetaData(QLatin1String("PropagateHttpHeader"), QLatin1String("true"));
+
+    auto it = m_entries.constFind(key(url));
+    if (it != m_entries.constEnd()) {
+        QStringList headers;
+        if (!it.value().etag.isEmpty()) {
+            headers << QLatin1String("If-None-Match: ") + it.value().etag;
+        }
+        if (!it.value().lastModified.isEmpty()) {
+            headers << QLatin1String("If-Modified-Since: ") + it.value().lastModified;
+        }
+        if (!headers.isEmpty()) {
+            job->addMetaData(QLatin1String("customHTTPHeader"), headers.join(QLatin1String("\r\n")));
+        }
+    }
+
+    connect(job, &KJob::result, this, &ScreenshotCache::jobFinished);
+    Request request;
+    request.url = url;
+    request.prefetch = prefetch;
+    m_jobs.insert(job, request);
+    if (prefetch) {
+        ++m_prefetching;
+    }
+}
+
+void ScreenshotCache::startQueued()
+{
+    // Prefetches wait for what the user asked for
+    for (const Request &request : qAsConst(m_jobs)) {
+        if (!request.prefetch) {
+            return;
+        }
+    }
+
+    while (m_prefetching < CACHE_PREFETCHES && !m_queue.isEmpty()) {
+        start(m_queue.takeFirst(), true);
+    }
+}
+
+void ScreenshotCache::touch(Entry &entry)
+{
+    entry.lastUsed = QDateTime::currentMSecsSinceEpoch();
+    m_saveTimer->start();
+}
+
+void ScreenshotCache::evict(const QString &keep)
+{
+    if (m_size <= m_maxSize) {
+        return;
+    }
+
+    QVector<QPair<qint64, QString> > entries;
+    entries.reserve(m_entries.size());
+    for (auto it = m_entries.constBegin(); it != m_entries.constEnd(); ++it) {
+        if (it.key() != keep) {
+            entries << qMakePair(it.value().lastUsed, it.key());
+        }
+    }
+    std::sort(entries.begin(), entries.end());
+
+    for (const auto &entry : qAsConst(entries)) {
+        if (m_size <= m_maxSize) {
+            break;
+        }
+        m_size -= m_entries.take(entry.second).size;
+        QFile::remove(filePath(entry.second));
+    }
+    m_saveTimer->start();
+}
+
+void ScreenshotCache::loadIndex()
+{
+    QFile file(m_directory + QLatin1String("/index"));
+    if (!file.open(QIODevice::ReadOnly)) {
+        return;
+    }
+
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_5_6);
+    quint32 magic, version, count;
+    stream >> magic >> version >> count;
+    if (magic != INDEX_MAGIC || version != INDEX_VERSION) {
+        return;
+    }
+
+    for (quint32 i = 0; i < count && stream.status() == QDataStream::Ok; ++i) {
+        QString fileKey;
+        Entry entry;
+        stream >> fileKey >> entry.etag >> entry.lastModified
+               >> entry.size >> entry.lastUsed >> entry.validated;
+
+        // Skip files removed behind our back
+        if (stream.status() == QDataStream::Ok && QFile::exists(filePath(fileKey))) {
+            m_entries.insert(fileKey, entry);
+            m_size += entry.size;
+        }
+    }
+}
+
+#include "moc_ScreenshotCache.cpp"
@@ -0,0 +1,118 @@
+/***************************************************************************
+ *   Copyright (C) 2026 by agent                                           *
+ *   agent@local                                                           *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; see the file COPYING. If not, write to       *
+ *   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,  *
+ *   Boston, MA 02110-1301, USA.                                           *
+ ***************************************************************************/
+
+#ifndef SCREENSHOT_CACHE_H
+#define SCREENSHOT_CACHE_H
+
+#include <QObject>
+#include <QHash>
+#include <QUrl>
+
+class KJob;
+class QTimer;
+
+/**
+ * Disk cache of AppStream thumbnails and screenshots.
+ *
+ * Files are named after the SHA-1 of their URL and kept under the
+ * XDG cache until the size limit is reached, then the least recently
+ * used ones are removed. Stale entries are revalidated with the
+ * ETag/Last-Modified the server sent.
+ */
+class ScreenshotCache : public QObject
+{
+    Q_OBJECT
+public:
+    static ScreenshotCache* instance();
+
+    explicit ScreenshotCache(const QString &directory, qint64 maxSize, QObject *parent = nullptr);
+    ~ScreenshotCache() override;
+
+    /**
+     * Returns the local copy of url or an empty string
+     * if it was never downloaded
+     */
+    QString fileName(const QUrl &url);
+
+    /**
+     * Emits ready() at once if url is on disk, and downloads it if it is
+     * missing or stale, in which case ready() might be emitted again
+     */
+    void fetch(const QUrl &url);
+
+    /**
+     * Replaces the prefetch queue with urls, they are downloaded
+     * a few at a time and only when nothing else is pending
+     */
+    void prefetch(const QList<QUrl> &urls);
+
+    /**
+     * Whether url is being downloaded or revalidated
+     */
+    bool isFetching(const QUrl &url) const;
+
+    qint64 size() const;
+    void setMaxSize(qint64 maxSize);
+    /**
+     * Entries older than maxAge milliseconds are revalidated on fetch()
+     */
+    void setMaxAge(qint64 maxAge);
+
+Q_SIGNALS:
+    void ready(const QUrl &url, const QString &fileName);
+    void failed(const QUrl &url);
+
+private Q_SLOTS:
+    void jobFinished(KJob *job);
+    void saveIndex();
+
+private:
+    struct Entry {
+        QString etag;
+        QString lastModified;
+        qint64  size = 0;
+        qint64  lastUsed = 0;
+        qint64  validated = 0;
+    };
+    struct Request {
+        QUrl url;
+        bool prefetch = false;
+    };
+
+    static QString key(const QUrl &url);
+    QString filePath(const QString &key) const;
+    void start(const QUrl &url, bool prefetch);
+    void startQueued();
+    void touch(Entry &entry);
+    void evict(const QString &keep);
+    void loadIndex();
+
+    QString m_directory;
+    qint64 m_maxSize;
+    qint64 m_maxAge;
+    qint64 m_size = 0;
+    QHash<QString, Entry> m_entries;
+    QHash<KJob*, Request> m_jobs;
+    QList<QUrl> m_queue;
+    int m_prefetching = 0;
+    QTimer *m_saveTimer;
+};
+
+#endif // SCREENSHOT_CACHE_H
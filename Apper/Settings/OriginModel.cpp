@@ -45,25 +45,95 @@ OriginModel::~OriginModel()
 bool OriginModel::setData(const QModelIndex &index, const QVariant &value, int role)
 {
     if (role == Qt::CheckStateRole && index.isValid()) {
-        Transaction *transaction = Daemon::repoEnable(index.data(RepoId).toString(),
-                                                      value.toBool());
-        connect(transaction, &Transaction::errorCode, this, &OriginModel::errorCode);
-        connect(transaction, &Transaction::finished, this, &OriginModel::setRepoFinished);
+        if (m_saving) {
+            // The list will be reloaded once saving is done
+            return false;
+        }
+        // Only staged here, save() applies it
+        if (!QStandardItemModel::setData(index, value, role)) {
+            return false;
+        }
+
+        QStandardItem *repo = itemFromIndex(index);
+        const bool checked = repo->checkState() == Qt::Checked;
+        if (checked != repo->data(RepoInitialState).toBool()) {
+            m_staged[repo->data(RepoId).toString()] = checked;
+        } else {
+            m_staged.remove(repo->data(RepoId).toString());
+        }
+        return true;
     }
     return false;
 }
 
-QVariantHash OriginModel::changes() const
+void OriginModel::save()
+{
+    if (m_saving) {
+        return;
+    }
+
+    const QVariantHash changed = changes();
+    if (changed.isEmpty()) {
+        return;
+    }
+
+    m_queue.clear();
+    for (auto it = changed.constBegin(); it != changed.constEnd(); ++it) {
+        m_queue << qMakePair(it.key(), it.value().toBool());
+    }
+    m_errors.clear();
+    m_errorDetails.clear();
+    m_changedRepos = false;
+    m_saving = true;
+    setNextRepo();
+}
+
+bool OriginModel::isSaving() const
+{
+    return m_saving;
+}
+
+void OriginModel::setNextRepo()
 {
-    QVariantHash ret;
-    for (int i = 0; i < rowCount(); ++i) {
-        QStandardItem *repo = item(i);
-        bool currentState = repo->checkState();
-        if (currentState != repo->data(RepoInitialState).toBool()) {
-            ret[repo->data(RepoId).toString()] = currentState;
+    if (m_queue.isEmpty()) {
+        m_saving = false;
+        // Applied or failed, the reloaded list shows which
+        m_staged.clear();
+        if (!m_errors.isEmpty()) {
+            KMessageBox::detailedError(nullptr,
+                                       i18np("The repository could not be changed.",
+                                             "%1 repositories could not be changed.",
+                                             m_errors.size()),
+                                       m_errorDetails,
+                                       m_errors.size() == 1 ? m_errors.first() : i18n("Failed to change repositories"),
+                                       KMessageBox::Notify);
         }
+
+        if (m_changedRepos) {
+            emit reposChanged();
+        }
+        // Whatever went through, the list now shows what PackageKit has
+        emit refreshRepoList();
+        return;
     }
-    return ret;
+
+    // Repositories are changed one after the other, so the
+    // transactions don't contend for the backend lock
+    const QPair<QString, bool> repo = m_queue.takeFirst();
+    Transaction *transaction = Daemon::repoEnable(repo.first, repo.second);
+    transaction->setProperty("RepoId", repo.first);
+    connect(transaction, &Transaction::errorCode, this, &OriginModel::errorCode);
+    connect(transaction, &Transaction::finished, this, &OriginModel::setRepoFinished);
+}
+
+QVariantHash OriginModel::changes() const
+{
+    return m_staged;
+}
+
+void OriginModel::discardChanges()
+{
+    m_staged.clear();
 }
 
 void OriginModel::addOriginItem(const QString &repo_id, const QString &details, bool enabled)
@@ -74,9 +144,19 @@ void OriginModel::addOriginItem(const QString &repo_id, const QString &details,
         m_finished = false;
     }
 
+    bool checked = enabled;
+    if (m_staged.contains(repo_id)) {
+        if (m_staged[repo_id].toBool() == enabled) {
+            // Already in the staged state
+            m_staged.remove(repo_id);
+        } else {
+            checked = !enabled;
+        }
+    }
+
     auto item = new QStandardItem(details);
     item->setCheckable(true);
-    item->setCheckState(enabled ? Qt::Checked : Qt::Unchecked);
+    item->setCheckState(checked ? Qt::Checked : Qt::Unchecked);
     item->setData(repo_id, RepoId);
     item->setData(enabled, RepoInitialState);
     appendRow(item);
@@ -90,16 +170,20 @@ void OriginModel::finished()
 void OriginModel::errorCode(PackageKit::Transaction::Error error, const QString &details)
 {
     if (error != Transaction::ErrorTransactionCancelled) {
-        KMessageBox::detailedError(nullptr, PkStrings::errorMessage(error), details, PkStrings::error(error), KMessageBox::Notify);
+        // Reported all together once the queue is done
+        m_errors << PkStrings::error(error);
+        m_errorDetails.append(sender()->property("RepoId").toString() + QLatin1String(": ") +
+                              PkStrings::errorMessage(error) + QLatin1Char('\n') + details + QLatin1Char('\n'));
     }
 }
 
 void OriginModel::setRepoFinished(Transaction::Exit exit)
 {
     if (exit == Transaction::ExitSuccess) {
-        emit refreshRepoList();
+        m_changedRepos = true;
     }
     sender()->deleteLater();
+    setNextRepo();
 }
 
 #include "moc_OriginModel.cpp"
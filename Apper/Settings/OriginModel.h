@@ -22,6 +22,10 @@
 #define ORIGIN_MODEL_H
 
 #include <QStandardItemModel>
+#include <QStringList>
+#include <QVariantHash>
+#include <QVector>
+#include <QPair>
 
 #include <Transaction>
 
@@ -38,10 +42,26 @@ public:
 
     bool setData(const QModelIndex &index, const QVariant &value, int role = Qt::EditRole) override;
 
+    /**
+     * The staged check states, they survive reloading the list
+     * so showing the development origins doesn't drop them
+     */
     QVariantHash changes() const;
+    /**
+     * Forgets the staged check states, the rows
+     * show them until the list is reloaded
+     */
+    void discardChanges();
+    /**
+     * Applies the staged repository changes one transaction
+     * at a time, refreshRepoList() is emitted once at the end
+     */
+    void save();
+    bool isSaving() const;
 
 Q_SIGNALS:
     void refreshRepoList();
+    void reposChanged();
 
 public Q_SLOTS:
     void addOriginItem(const QString &repo_id, const QString &details, bool enabled);
@@ -52,7 +72,17 @@ private Q_SLOTS:
     void setRepoFinished(PackageKit::Transaction::Exit exit);
 
 private:
+    void setNextRepo();
+
     bool m_finished;
+    // Repository id to the state the user checked
+    QVariantHash m_staged;
+    // Staged changes waiting for their turn while saving
+    QVector<QPair<QString, bool> > m_queue;
+    QStringList m_errors;
+    QString m_errorDetails;
+    bool m_saving = false;
+    bool m_changedRepos = false;
 };
 
 #endif
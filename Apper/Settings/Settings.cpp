@@ -76,7 +76,8 @@ Settings::Settings(Transaction::Roles roles, QWidget *parent) :
 
     m_originModel = new OriginModel(this);
     connect(m_originModel, &OriginModel::refreshRepoList, this, &Settings::refreshRepoModel);
-    connect(m_originModel, &OriginModel::refreshRepoList, ui->messageWidget, &KMessageWidget::animatedShow);
+    connect(m_originModel, &OriginModel::reposChanged, ui->messageWidget, &KMessageWidget::animatedShow);
+    connect(m_originModel, &OriginModel::dataChanged, this, &Settings::checkChanges);
     auto proxy = new QSortFilterProxyModel(this);
     proxy->setDynamicSortFilter(true);
     proxy->setSourceModel(m_originModel);
@@ -124,6 +125,7 @@ Settings::Settings(Transaction::Roles roles, QWidget *parent) :
     connect(ui->autoCB, QOverload<int>::of(&KComboBox::currentIndexChanged), this, &Settings::checkChanges);
     connect(ui->installUpdatesBatteryCB, &QCheckBox::stateChanged, this, &Settings::checkChanges);
     connect(ui->installUpdatesMobileCB, &QCheckBox::stateChanged, this, &Settings::checkChanges);
+    connect(ui->prepareOfflineCB, &QCheckBox::stateChanged, this, &Settings::checkChanges);
 
     // Setup buttons
     QPushButton *apply = ui->buttonBox->button(QDialogButtonBox::Apply);
@@ -208,9 +210,13 @@ bool Settings::hasChanges() const
         ||
         ui->installUpdatesMobileCB->isChecked() != checkUpdateGroup.readEntry(CFG_INSTALL_UP_MOBILE, DEFAULT_INSTALL_UP_MOBILE)
         ||
+        ui->prepareOfflineCB->isChecked() != checkUpdateGroup.readEntry(CFG_PREPARE_OFFLINE, DEFAULT_PREPARE_OFFLINE)
+        ||
         ui->autoConfirmCB->isChecked() != !requirementsDialog.readEntry("autoConfirm", false)
         ||
-        ui->appLauncherCB->isChecked() != transaction.readEntry("ShowApplicationLauncher", true)) {
+        ui->appLauncherCB->isChecked() != transaction.readEntry("ShowApplicationLauncher", true)
+        ||
+        (!m_originModel->isSaving() && !m_originModel->changes().isEmpty())) {
         return true;
     }
     return false;
@@ -227,8 +233,10 @@ void Settings::checkChanges()
 
     ui->autoInsL->setEnabled(enabled);
     ui->autoCB->setEnabled(enabled);
+    uint autoUpdate = ui->autoCB->itemData(ui->autoCB->currentIndex()).toUInt();
+    ui->prepareOfflineCB->setEnabled(enabled && autoUpdate == Enum::DownloadOnly);
     if (enabled) {
-        enabled = ui->autoCB->itemData(ui->autoCB->currentIndex()).toUInt() != Enum::None;
+        enabled = autoUpdate != Enum::None;
     }
     ui->installUpdatesMobileCB->setEnabled(enabled);
     ui->installUpdatesBatteryCB->setEnabled(enabled);
@@ -275,8 +283,11 @@ void Settings::load()
     }
     ui->installUpdatesBatteryCB->setChecked(checkUpdateGroup.readEntry(CFG_INSTALL_UP_BATTERY, DEFAULT_INSTALL_UP_BATTERY));
     ui->installUpdatesMobileCB->setChecked(checkUpdateGroup.readEntry(CFG_INSTALL_UP_MOBILE, DEFAULT_INSTALL_UP_MOBILE));
+    ui->prepareOfflineCB->setChecked(checkUpdateGroup.readEntry(CFG_PREPARE_OFFLINE, DEFAULT_PREPARE_OFFLINE));
 
-    // Load origns list
+    // Load origns list, what was staged
+    // but not applied is thrown away
+    m_originModel->discardChanges();
     if (m_roles & Transaction::RoleGetRepoList) {
         KConfigGroup originsDialog(&config, "originsDialog");
         bool showDevel = originsDialog.readEntry("showDevel", false);
@@ -325,6 +336,13 @@ void Settings::save()
     checkUpdateGroup.writeEntry("autoUpdate", ui->autoCB->itemData(ui->autoCB->currentIndex()).toUInt());
     checkUpdateGroup.writeEntry("installUpdatesOnBattery", ui->installUpdatesBatteryCB->isChecked());
     checkUpdateGroup.writeEntry("installUpdatesOnMobile", ui->installUpdatesMobileCB->isChecked());
+    checkUpdateGroup.writeEntry(CFG_PREPARE_OFFLINE, ui->prepareOfflineCB->isChecked());
+
+    if (!m_originModel->changes().isEmpty()) {
+        // The list is reloaded once all the repositories are changed
+        m_busySeq->start();
+        m_originModel->save();
+    }
 
     emit changed(false);
 }
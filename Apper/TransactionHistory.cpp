@@ -58,7 +58,12 @@ TransactionHistory::~TransactionHistory()
 
 void TransactionHistory::setFilterRegExp(const QString &regexp)
 {
-    m_proxyModel->setFilterRegExp(regexp);
+    if (m_transactionModel->setSearch(regexp)) {
+        // the store already did the filtering
+        m_proxyModel->setFilterRegExp(QString());
+    } else {
+        m_proxyModel->setFilterRegExp(regexp);
+    }
 }
 
 void TransactionHistory::on_treeView_customContextMenuRequested(const QPoint &pos)
@@ -73,9 +78,7 @@ void TransactionHistory::on_treeView_customContextMenuRequested(const QPoint &po
 void TransactionHistory::refreshList()
 {
     // Refresh transaction list
-    m_transactionModel->clear();
-    Transaction *transaction = Daemon::getOldTransactions(0);
-    connect(transaction, &Transaction::transaction, m_transactionModel, &TransactionModel::addTransaction);
+    m_transactionModel->refresh();
 
     // Refresh time
     QString text;
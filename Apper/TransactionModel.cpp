@@ -20,138 +20,406 @@
 
 #include "TransactionModel.h"
 
+#include <Daemon>
+
 #include <KUser>
 #include <KFormat>
 #include <KLocalizedString>
 #include <QLoggingCategory>
 
+#include <climits>
+
 #include <PkIcons.h>
 #include <PkStrings.h>
 
+// Rows added each time the view scrolls to the bottom
+#define HISTORY_PAGE_SIZE 100
+
 using namespace PackageKit;
 
 TransactionModel::TransactionModel(QObject *parent)
-: QStandardItemModel(parent)
+: QAbstractTableModel(parent)
 {
-    setSortRole(Qt::DisplayRole);
-    clear();
+    m_store = HistoryStore::instance();
+    if (m_store->isValid()) {
+        connect(m_store, &HistoryStore::synced, this, &TransactionModel::storeSynced);
+    } else {
+        m_store = nullptr;
+    }
 }
 
 void TransactionModel::clear()
 {
-    QStandardItemModel::clear();
-    setHorizontalHeaderItem(0, new QStandardItem(i18n("Date")));
-    setHorizontalHeaderItem(1, new QStandardItem(i18n("Action")));
-    setHorizontalHeaderItem(2, new QStandardItem(i18n("Details")));
-    setHorizontalHeaderItem(3, new QStandardItem(i18nc("Machine user who issued the transaction", "Username")));
-    setHorizontalHeaderItem(4, new QStandardItem(i18n("Application")));
+    if (m_transaction) {
+        // ignore whatever is still to come from an older request
+        m_transaction->disconnect(this);
+        m_transaction = nullptr;
+    }
+
+    beginResetModel();
+    m_records.clear();
+    m_tids.clear();
+    m_rows = 0;
+    m_wanted = 0;
+    m_requested = 0;
+    m_received = 0;
+    m_complete = false;
+    endResetModel();
 }
 
-void TransactionModel::addTransaction(PackageKit::Transaction *trans)
+void TransactionModel::refresh()
 {
-    auto dateI    = new QStandardItem;
-    auto roleI    = new QStandardItem;
-    auto detailsI = new QStandardItem;
-    auto userI    = new QStandardItem;
-    auto appI     = new QStandardItem;
+    clear();
+    m_wanted = HISTORY_PAGE_SIZE;
+    if (m_store) {
+        // Show what we have now, storeSynced() adds what is new
+        loadStored(HISTORY_PAGE_SIZE);
+        if (!m_store->isSyncing()) {
+            m_store->sync();
+        }
+        return;
+    }
+    request(HISTORY_PAGE_SIZE);
+}
 
-    dateI->setText(QLocale::system().toString(trans->timespec().date()));
-    // this is for the filterSort model
-    dateI->setData(trans->timespec(), Qt::UserRole);
-    dateI->setEditable(false);
+void TransactionModel::fetchAll()
+{
+    if (m_store) {
+        loadStored(INT_MAX);
+        return;
+    }
 
-    roleI->setText(PkStrings::actionPast(trans->role()));
-    roleI->setIcon(PkIcons::actionIcon(trans->role()));
-    roleI->setEditable(false);
+    m_wanted = INT_MAX;
+    showRecords();
+    if (!m_complete && !m_transaction) {
+        request(0);
+    }
+}
 
-    detailsI->setText(getDetailsLocalized(trans->data()));
-    detailsI->setEditable(false);
+int TransactionModel::rowCount(const QModelIndex &parent) const
+{
+    if (parent.isValid()) {
+        return 0;
+    }
+    return m_rows;
+}
 
-    KUser user(trans->uid());
-    QString display;
-    if (!user.property(KUser::FullName).toString().isEmpty()) {
-        display = user.property(KUser::FullName).toString() + QLatin1String(" (") + user.loginName() + QLatin1Char(')');
-    } else {
-        display = user.loginName();
+int TransactionModel::columnCount(const QModelIndex &parent) const
+{
+    if (parent.isValid()) {
+        return 0;
     }
-    userI->setText(display);
-    userI->setEditable(false);
+    return ApplicationCol + 1;
+}
 
-    appI->setText(trans->cmdline());
-    appI->setEditable(false);
+QVariant TransactionModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || index.row() >= m_rows) {
+        return QVariant();
+    }
 
-    appendRow({
-                  dateI,
-                  roleI,
-                  detailsI,
-                  userI,
-                  appI
-              });
-    delete trans;
+    const Record &record = m_records.at(index.row());
+    switch (index.column()) {
+    case DateCol:
+        if (role == Qt::DisplayRole) {
+            return QLocale::system().toString(record.timespec.date());
+        } else if (role == Qt::UserRole) {
+            // this is for the filterSort model
+            return record.timespec;
+        }
+        break;
+    case ActionCol:
+        if (role == Qt::DisplayRole) {
+            return PkStrings::actionPast(record.role);
+        } else if (role == Qt::DecorationRole) {
+            return PkIcons::actionIcon(record.role);
+        }
+        break;
+    case DetailsCol:
+        if (role == Qt::DisplayRole) {
+            if (!record.hasDetails) {
+                record.details = getDetailsLocalized(record.data);
+                record.hasDetails = true;
+            }
+            return record.details;
+        }
+        break;
+    case UserCol:
+        if (role == Qt::DisplayRole) {
+            return userName(record.uid);
+        }
+        break;
+    case ApplicationCol:
+        if (role == Qt::DisplayRole) {
+            return record.cmdline;
+        }
+        break;
+    }
+    return QVariant();
 }
 
-QString TransactionModel::getDetailsLocalized(const QString &data) const
+QVariant TransactionModel::headerData(int section, Qt::Orientation orientation, int role) const
 {
-    QStringList lines = data.split(QLatin1Char('\n'));
-    QStringList ret;
+    if (orientation != Qt::Horizontal || role != Qt::DisplayRole) {
+        return QVariant();
+    }
 
-    QString text;
-    text = getTypeLine(lines, Transaction::StatusInstall);
-    if (!text.isNull()) {
-        ret << text;
+    switch (section) {
+    case DateCol:
+        return i18n("Date");
+    case ActionCol:
+        return i18n("Action");
+    case DetailsCol:
+        return i18n("Details");
+    case UserCol:
+        return i18nc("Machine user who issued the transaction", "Username");
+    case ApplicationCol:
+        return i18n("Application");
     }
+    return QVariant();
+}
 
-    text = getTypeLine(lines, Transaction::StatusRemove);
-    if (!text.isNull()) {
-        ret << text;
+bool TransactionModel::setSearch(const QString &search)
+{
+    if (!m_store) {
+        if (!search.isEmpty()) {
+            // searching only makes sense on the whole history
+            fetchAll();
+        }
+        return false;
     }
 
-    text = getTypeLine(lines, Transaction::StatusUpdate);
-    if (!text.isNull()) {
-        ret << text;
+    if (m_search != search) {
+        m_search = search;
+        clear();
+        loadStored(HISTORY_PAGE_SIZE);
     }
+    return true;
+}
 
-    return ret.join(QLatin1Char('\n'));
+bool TransactionModel::canFetchMore(const QModelIndex &parent) const
+{
+    if (parent.isValid() || m_transaction) {
+        return false;
+    }
+    return m_rows < m_records.size() || !m_complete;
 }
 
-QString TransactionModel::getTypeLine(const QStringList &lines, Transaction::Status status) const
-{
-    QStringList text;
-    for (const QString &line : lines) {
-        const QStringList sections = line.split(QLatin1Char('\t'));
-        if (sections.size() > 1) {
-            switch (status) {
-                case Transaction::StatusInstall:
-                    if (sections.at(0) != QLatin1String("installing")) {
-                        continue;
-                    }
-                    break;
-                case Transaction::StatusRemove:
-                    if (sections.at(0) != QLatin1String("removing")) {
-                        continue;
-                    }
-                    break;
-                case Transaction::StatusUpdate:
-                    if (sections.at(0) != QLatin1String("updating")) {
-                        continue;
-                    }
-                    break;
-                default:
-                    continue;
-            }
-            QStringList packageData = sections.at(1).split(QLatin1Char(';'));
-            if (packageData.size()) {
-                text << packageData.at(0);
+void TransactionModel::fetchMore(const QModelIndex &parent)
+{
+    if (parent.isValid() || m_transaction) {
+        return;
+    }
+
+    if (m_store) {
+        loadStored(HISTORY_PAGE_SIZE);
+        return;
+    }
+
+    m_wanted = m_rows + HISTORY_PAGE_SIZE;
+    showRecords();
+    if (m_records.size() < m_wanted && !m_complete) {
+        request(qMax<uint>(m_requested * 2, m_wanted));
+    }
+}
+
+void TransactionModel::addTransaction(PackageKit::Transaction *trans)
+{
+    ++m_received;
+
+    const QString tid = trans->tid().path();
+    if (!m_tids.contains(tid)) {
+        m_tids.insert(tid);
+
+        Record record;
+        record.tid = tid;
+        record.timespec = trans->timespec();
+        record.role = trans->role();
+        record.uid = trans->uid();
+        record.cmdline = trans->cmdline();
+        record.data = trans->data();
+        m_records.append(record);
+        showRecords();
+    }
+    delete trans;
+}
+
+void TransactionModel::requestFinished()
+{
+    // A short answer means we got to the oldest transaction
+    if (m_requested == 0 || m_received < m_requested) {
+        m_complete = true;
+    }
+    m_transaction = nullptr;
+
+    if (m_records.size() < m_wanted && !m_complete) {
+        request(qMax<uint>(m_requested * 2, m_wanted == INT_MAX ? 0 : m_wanted));
+    }
+}
+
+void TransactionModel::storeSynced()
+{
+    if (!m_store->isValid()) {
+        // The store could not be opened, ask PackageKit directly
+        disconnect(m_store, nullptr, this, nullptr);
+        m_store = nullptr;
+        refresh();
+        return;
+    }
+
+    if (m_records.isEmpty()) {
+        loadStored(HISTORY_PAGE_SIZE);
+        return;
+    }
+
+    // New transactions are the newest, collect them until
+    // reaching one we show so the view keeps its place
+    QVector<Record> fresh;
+    bool reached = false;
+    int offset = 0;
+    while (!reached) {
+        const QVector<HistoryStore::Entry> entries = m_store->transactions(offset, HISTORY_PAGE_SIZE, m_search);
+        for (const HistoryStore::Entry &entry : entries) {
+            if (m_tids.contains(entry.tid)) {
+                reached = true;
+                break;
             }
+            fresh << toRecord(entry);
         }
+
+        if (entries.size() < HISTORY_PAGE_SIZE) {
+            break;
+        }
+        offset += entries.size();
+    }
+
+    if (!reached) {
+        // None of the rows is stored anymore, start over keeping
+        // as many rows as the user has already scrolled through
+        const int count = qMax(m_rows, HISTORY_PAGE_SIZE);
+        clear();
+        loadStored(count);
+        return;
+    }
+
+    if (fresh.isEmpty()) {
+        return;
+    }
+
+    // The store offset of the next page moves along with the rows
+    beginInsertRows(QModelIndex(), 0, fresh.size() - 1);
+    for (const Record &record : qAsConst(fresh)) {
+        m_tids.insert(record.tid);
+    }
+    m_records = fresh + m_records;
+    m_rows += fresh.size();
+    m_wanted += fresh.size();
+    endInsertRows();
+}
+
+void TransactionModel::loadStored(int count)
+{
+    const QVector<HistoryStore::Entry> entries = m_store->transactions(m_records.size(), count, m_search);
+    for (const HistoryStore::Entry &entry : entries) {
+        m_tids.insert(entry.tid);
+        m_records.append(toRecord(entry));
+    }
+    m_complete = entries.size() < count;
+    m_wanted = m_records.size();
+    showRecords();
+}
+
+TransactionModel::Record TransactionModel::toRecord(const HistoryStore::Entry &entry)
+{
+    Record record;
+    record.tid = entry.tid;
+    record.timespec = entry.timespec;
+    record.role = entry.role;
+    record.uid = entry.uid;
+    record.cmdline = entry.cmdline;
+    record.data = entry.data;
+    return record;
+}
+
+void TransactionModel::request(uint count)
+{
+    m_requested = count;
+    m_received = 0;
+    m_transaction = Daemon::getOldTransactions(count);
+    connect(m_transaction, &Transaction::transaction, this, &TransactionModel::addTransaction);
+    connect(m_transaction, &Transaction::finished, this, &TransactionModel::requestFinished);
+}
+
+void TransactionModel::showRecords()
+{
+    const int count = qMin(m_records.size(), m_wanted);
+    if (count > m_rows) {
+        beginInsertRows(QModelIndex(), m_rows, count - 1);
+        m_rows = count;
+        endInsertRows();
     }
+}
 
-    if (text.size()) {
-        // TODO make the status BOLD
-        return PkStrings::statusPast(status) + QLatin1String(": ") + text.join(QLatin1String(", "));
+QString TransactionModel::userName(uint uid) const
+{
+    auto it = m_userNames.constFind(uid);
+    if (it != m_userNames.constEnd()) {
+        return it.value();
+    }
+
+    KUser user(uid);
+    QString display;
+    const QString fullName = user.property(KUser::FullName).toString();
+    if (!fullName.isEmpty()) {
+        display = fullName + QLatin1String(" (") + user.loginName() + QLatin1Char(')');
     } else {
-        return QString();
+        display = user.loginName();
     }
+    m_userNames.insert(uid, display);
+    return display;
+}
+
+QString TransactionModel::getDetailsLocalized(const QString &data) const
+{
+    // Each line looks like "installing\tname;version;arch;repo"
+    QStringList installed;
+    QStringList removed;
+    QStringList updated;
+    for (const QStringRef &line : data.splitRef(QLatin1Char('\n'))) {
+        const int tab = line.indexOf(QLatin1Char('\t'));
+        if (tab == -1) {
+            continue;
+        }
+
+        const QStringRef type = line.left(tab);
+        QStringList *list;
+        if (type == QLatin1String("installing")) {
+            list = &installed;
+        } else if (type == QLatin1String("removing")) {
+            list = &removed;
+        } else if (type == QLatin1String("updating")) {
+            list = &updated;
+        } else {
+            continue;
+        }
+
+        const QStringRef packageData = line.mid(tab + 1);
+        *list << packageData.left(packageData.indexOf(QLatin1Char(';'))).toString();
+    }
+
+    QStringList ret;
+    // TODO make the status BOLD
+    if (!installed.isEmpty()) {
+        ret << PkStrings::statusPast(Transaction::StatusInstall) + QLatin1String(": ") + installed.join(QLatin1String(", "));
+    }
+    if (!removed.isEmpty()) {
+        ret << PkStrings::statusPast(Transaction::StatusRemove) + QLatin1String(": ") + removed.join(QLatin1String(", "));
+    }
+    if (!updated.isEmpty()) {
+        ret << PkStrings::statusPast(Transaction::StatusUpdate) + QLatin1String(": ") + updated.join(QLatin1String(", "));
+    }
+
+    return ret.join(QLatin1Char('\n'));
 }
 
 #include "moc_TransactionModel.cpp"
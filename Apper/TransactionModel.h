@@ -21,26 +21,103 @@
 #ifndef TRANSACTION_MODEL_H
 #define TRANSACTION_MODEL_H
 
-#include <QStandardItemModel>
+#include <QAbstractTableModel>
+#include <QDateTime>
+#include <QHash>
+#include <QSet>
+#include <QVector>
+
 #include <Transaction>
 
+#include "HistoryStore.h"
+
 using namespace PackageKit;
 
-class TransactionModel : public QStandardItemModel
+/**
+ * The transaction history, newest first.
+ *
+ * Transactions are read from the local HistoryStore, or asked to
+ * PackageKit if it is not available, and shown in pages as the
+ * view scrolls, the details column is only parsed once it is
+ * displayed and user names are looked up once per uid.
+ */
+class TransactionModel : public QAbstractTableModel
 {
 Q_OBJECT
 
 public:
+    enum {
+        DateCol = 0,
+        ActionCol,
+        DetailsCol,
+        UserCol,
+        ApplicationCol
+    };
     explicit TransactionModel(QObject *parent = nullptr);
 
     void clear();
+    /**
+     * Drops the loaded transactions and fetches the newest ones again
+     */
+    void refresh();
+    /**
+     * Loads the whole history, needed to search through it
+     */
+    void fetchAll();
+    /**
+     * Shows only the transactions matching search, returns false if
+     * there is no HistoryStore and the caller has to filter the rows
+     */
+    bool setSearch(const QString &search);
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+
+    bool canFetchMore(const QModelIndex &parent) const override;
+    void fetchMore(const QModelIndex &parent) override;
 
 public Q_SLOTS:
     void addTransaction(PackageKit::Transaction *trans);
 
+private Q_SLOTS:
+    void requestFinished();
+    void storeSynced();
+
 private:
+    struct Record {
+        QString tid;
+        QDateTime timespec;
+        Transaction::Role role = Transaction::RoleUnknown;
+        uint uid = 0;
+        QString cmdline;
+        QString data;
+        mutable QString details;
+        mutable bool hasDetails = false;
+    };
+
+    void request(uint count);
+    void loadStored(int count);
+    static Record toRecord(const HistoryStore::Entry &entry);
+    void showRecords();
+    QString userName(uint uid) const;
     QString getDetailsLocalized(const QString &data) const;
-    QString getTypeLine(const QStringList &lines, Transaction::Status status) const;
+
+    QVector<Record> m_records;
+    QSet<QString> m_tids;
+    // records the view can see, the rest waits for fetchMore()
+    int m_rows = 0;
+    int m_wanted = 0;
+    // PackageKit has no offset, so each request asks for more
+    // of the newest transactions and the known ones are skipped
+    uint m_requested = 0;
+    uint m_received = 0;
+    bool m_complete = false;
+    Transaction *m_transaction = nullptr;
+    HistoryStore *m_store = nullptr;
+    QString m_search;
+    mutable QHash<uint, QString> m_userNames;
 };
 
 #endif
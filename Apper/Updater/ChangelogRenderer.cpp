@@ -0,0 +1,186 @@
+/***************************************************************************
+ *   Copyright (C) 2026 by agent                                           *
+ *   agent@local                                                           *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; see the file COPYING. If not, write to       *
+ *   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,  *
+ *   Boston, MA 02110-1301, USA.                                           *
+ ***************************************************************************/
+
+#include "ChangelogRenderer.h"
+
+namespace {
+
+// Returns true if the marker of size markerSize is found again
+// in line between from and length
+bool hasClosing(const QChar *line, int from, int length, QChar marker, int markerSize)
+{
+    for (int i = from; i + markerSize <= length; ++i) {
+        if (line[i] == marker && (markerSize == 1 || line[i + 1] == marker)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool startsWith(const QChar *line, int pos, int length, const char *prefix)
+{
+    for (; *prefix; ++prefix, ++pos) {
+        if (pos >= length || line[pos] != QLatin1Char(*prefix)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void appendEscaped(QString &html, QChar c)
+{
+    switch (c.unicode()) {
+    case '&':
+        html += QLatin1String("&amp;");
+        break;
+    case '<':
+        html += QLatin1String("&lt;");
+        break;
+    case '>':
+        html += QLatin1String("&gt;");
+        break;
+    case '"':
+        html += QLatin1String("&quot;");
+        break;
+    default:
+        html += c;
+    }
+}
+
+}
+
+QString ChangelogRenderer::toHtml(const QString &text, int maxLength, bool *truncated)
+{
+    int end = text.size();
+    bool cut = false;
+    if (maxLength > 0 && end > maxLength) {
+        // Cut on a line break so we don't leave half a line
+        const int lineBreak = text.lastIndexOf(QLatin1Char('\n'), maxLength);
+        end = lineBreak > 0 ? lineBreak : maxLength;
+        cut = true;
+    }
+    if (truncated) {
+        *truncated = cut;
+    }
+
+    // Markup usually adds little, so this avoids reallocations
+    QString html;
+    html.reserve(end + end / 4 + 64);
+
+    const QChar *data = text.constData();
+    int pos = 0;
+    while (pos < end) {
+        int lineEnd = pos;
+        while (lineEnd < end && data[lineEnd] != QLatin1Char('\n')) {
+            ++lineEnd;
+        }
+
+        renderLine(html, data + pos, lineEnd - pos);
+        if (lineEnd < end) {
+            html += QLatin1String("<br/>");
+        }
+        pos = lineEnd + 1;
+    }
+
+    return html;
+}
+
+void ChangelogRenderer::renderLine(QString &html, const QChar *line, int length)
+{
+    int pos = 0;
+
+    // Indentation
+    while (pos < length && line[pos] == QLatin1Char(' ')) {
+        html += QLatin1String("&nbsp;");
+        ++pos;
+    }
+
+    // Block markers
+    bool heading = false;
+    if (pos < length && line[pos] == QLatin1Char('#')) {
+        int level = pos;
+        while (level < length && line[level] == QLatin1Char('#')) {
+            ++level;
+        }
+        if (level - pos <= 6 && level < length && line[level] == QLatin1Char(' ')) {
+            heading = true;
+            pos = level + 1;
+            html += QLatin1String("<b>");
+        }
+    } else if (pos + 1 < length &&
+               (line[pos] == QLatin1Char('-') || line[pos] == QLatin1Char('*') || line[pos] == QLatin1Char('+')) &&
+               line[pos + 1] == QLatin1Char(' ')) {
+        html += QString::fromUtf8("\xE2\x80\xA2 ");
+        pos += 2;
+    }
+
+    // Inline markup
+    bool bold = false;
+    bool code = false;
+    while (pos < length) {
+        const QChar c = line[pos];
+        if (c == QLatin1Char('`') && (code || hasClosing(line, pos + 1, length, c, 1))) {
+            html += code ? QLatin1String("</tt>") : QLatin1String("<tt>");
+            code = !code;
+            ++pos;
+        } else if (!code && c == QLatin1Char('*') && pos + 1 < length && line[pos + 1] == QLatin1Char('*') &&
+                   (bold || hasClosing(line, pos + 2, length, c, 2))) {
+            html += bold ? QLatin1String("</b>") : QLatin1String("<b>");
+            bold = !bold;
+            pos += 2;
+        } else if (!code && c == QLatin1Char('h') &&
+                   (pos == 0 || line[pos - 1].isSpace() || line[pos - 1] == QLatin1Char('(')) &&
+                   (startsWith(line, pos, length, "http://") || startsWith(line, pos, length, "https://"))) {
+            int urlEnd = pos;
+            while (urlEnd < length && !line[urlEnd].isSpace() &&
+                   line[urlEnd] != QLatin1Char('<') && line[urlEnd] != QLatin1Char('>') &&
+                   line[urlEnd] != QLatin1Char(')') && line[urlEnd] != QLatin1Char('"')) {
+                ++urlEnd;
+            }
+            html += QLatin1String("<a href=\"");
+            for (int i = pos; i < urlEnd; ++i) {
+                appendEscaped(html, line[i]);
+            }
+            html += QLatin1String("\">");
+            for (int i = pos; i < urlEnd; ++i) {
+                appendEscaped(html, line[i]);
+            }
+            html += QLatin1String("</a>");
+            pos = urlEnd;
+        } else if (c == QLatin1Char(' ') && pos + 1 < length && line[pos + 1] == QLatin1Char(' ')) {
+            // Keep alignment of columns without preventing wrapping
+            html += QLatin1String(" &nbsp;");
+            pos += 2;
+        } else {
+            appendEscaped(html, c);
+            ++pos;
+        }
+    }
+
+    if (code) {
+        html += QLatin1String("</tt>");
+    }
+    if (bold) {
+        html += QLatin1String("</b>");
+    }
+    if (heading) {
+        html += QLatin1String("</b>");
+    }
+}
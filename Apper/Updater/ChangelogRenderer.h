@@ -0,0 +1,48 @@
+/***************************************************************************
+ *   Copyright (C) 2026 by agent                                           *
+ *   agent@local                                                           *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; see the file COPYING. If not, write to       *
+ *   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,  *
+ *   Boston, MA 02110-1301, USA.                                           *
+ ***************************************************************************/
+
+#ifndef CHANGELOG_RENDERER_H
+#define CHANGELOG_RENDERER_H
+
+#include <QString>
+
+/**
+ * Converts update texts and changelogs, which are plain text or a
+ * small subset of Markdown, to HTML in a single pass.
+ *
+ * Supported: headings (#), list items (-, *, +), **bold**, `code`
+ * and http(s) links; everything else is escaped, line breaks and
+ * indentation are kept.
+ */
+class ChangelogRenderer
+{
+public:
+    /**
+     * When maxLength is greater than zero only about that many
+     * characters of text are rendered, truncated is set if some
+     * were left out
+     */
+    static QString toHtml(const QString &text, int maxLength = 0, bool *truncated = nullptr);
+
+private:
+    static void renderLine(QString &html, const QChar *line, int length);
+};
+
+#endif
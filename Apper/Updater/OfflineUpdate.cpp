@@ -0,0 +1,153 @@
+/***************************************************************************
+ *   Copyright (C) 2026 by agent                                           *
+ *   agent@local                                                           *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; see the file COPYING. If not, write to       *
+ *   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,  *
+ *   Boston, MA 02110-1301, USA.                                           *
+ ***************************************************************************/
+
+#include "OfflineUpdate.h"
+
+#include <Daemon>
+#include <Offline>
+
+#include <QAction>
+#include <QDBusPendingCallWatcher>
+#include <QDBusPendingReply>
+
+#include <KFormat>
+#include <KLocalizedString>
+
+#include <QLoggingCategory>
+
+Q_DECLARE_LOGGING_CATEGORY(APPER)
+
+using namespace PackageKit;
+
+OfflineUpdate::OfflineUpdate(QWidget *parent) :
+    KMessageWidget(parent)
+{
+    setMessageType(KMessageWidget::Information);
+    setWordWrap(true);
+
+    m_installAction = new QAction(i18n("Install on Next Reboot"), this);
+    connect(m_installAction, &QAction::triggered, this, &OfflineUpdate::installOnReboot);
+    addAction(m_installAction);
+
+    m_cancelAction = new QAction(i18n("Cancel"), this);
+    connect(m_cancelAction, &QAction::triggered, this, &OfflineUpdate::cancelOfflineUpdate);
+    addAction(m_cancelAction);
+
+    connect(Daemon::global()->offline(), &Offline::changed, this, &OfflineUpdate::refresh);
+}
+
+OfflineUpdate::~OfflineUpdate()
+{
+}
+
+void OfflineUpdate::refresh()
+{
+    if (!Daemon::global()->offline()->updatePrepared()) {
+        m_count = 0;
+        animatedHide();
+        return;
+    }
+
+    auto call = new QDBusPendingCallWatcher(Daemon::global()->offline()->getPrepared(), this);
+    connect(call, &QDBusPendingCallWatcher::finished, this, [this] (QDBusPendingCallWatcher *call) {
+        call->deleteLater();
+
+        QDBusPendingReply<QStringList> reply = *call;
+        if (reply.isError() || reply.value().isEmpty()) {
+            animatedHide();
+            return;
+        }
+
+        const QStringList packageIDs = reply.value();
+        m_count = packageIDs.size();
+        m_size = 0;
+        updateText();
+        animatedShow();
+
+        // The staged size is the size of the prepared packages
+        if (!m_detailsT) {
+            m_detailsT = Daemon::getDetails(packageIDs);
+            connect(m_detailsT, &Transaction::details, this, &OfflineUpdate::details);
+            connect(m_detailsT, &Transaction::finished, this, &OfflineUpdate::detailsFinished);
+        }
+    });
+}
+
+void OfflineUpdate::installOnReboot()
+{
+    auto call = new QDBusPendingCallWatcher(Daemon::global()->offline()->trigger(Offline::ActionReboot), this);
+    connect(call, &QDBusPendingCallWatcher::finished, this, [this] (QDBusPendingCallWatcher *call) {
+        call->deleteLater();
+        if (call->isError()) {
+            qCWarning(APPER) << "Failed to trigger the offline update" << call->error().message();
+            setMessageType(KMessageWidget::Error);
+            setText(i18n("The updates could not be scheduled for installation: %1", call->error().message()));
+        }
+    });
+}
+
+void OfflineUpdate::cancelOfflineUpdate()
+{
+    auto call = new QDBusPendingCallWatcher(Daemon::global()->offline()->cancel(), this);
+    connect(call, &QDBusPendingCallWatcher::finished, this, [] (QDBusPendingCallWatcher *call) {
+        call->deleteLater();
+        if (call->isError()) {
+            qCWarning(APPER) << "Failed to cancel the offline update" << call->error().message();
+        }
+    });
+}
+
+void OfflineUpdate::details(const Details &details)
+{
+    m_size += details.size();
+}
+
+void OfflineUpdate::detailsFinished()
+{
+    m_detailsT = nullptr;
+    updateText();
+}
+
+void OfflineUpdate::updateText()
+{
+    const bool triggered = Daemon::global()->offline()->updateTriggered();
+    m_installAction->setVisible(!triggered);
+    m_cancelAction->setVisible(triggered);
+    setMessageType(KMessageWidget::Information);
+
+    QString text;
+    if (triggered) {
+        text = i18np("One update will be installed on the next reboot",
+                     "%1 updates will be installed on the next reboot",
+                     m_count);
+    } else {
+        text = i18np("One update is prepared to be installed on the next reboot",
+                     "%1 updates are prepared to be installed on the next reboot",
+                     m_count);
+    }
+
+    if (m_size) {
+        text = i18nc("Offline update state and the size of the staged packages", "%1 (%2)",
+                     text, KFormat().formatByteSize(m_size));
+    }
+    setText(text);
+}
+
+#include "moc_OfflineUpdate.cpp"
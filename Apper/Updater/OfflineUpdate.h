@@ -0,0 +1,59 @@
+/***************************************************************************
+ *   Copyright (C) 2026 by agent                                           *
+ *   agent@local                                                           *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; see the file COPYING. If not, write to       *
+ *   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,  *
+ *   Boston, MA 02110-1301, USA.                                           *
+ ***************************************************************************/
+
+#ifndef OFFLINE_UPDATE_H
+#define OFFLINE_UPDATE_H
+
+#include <KMessageWidget>
+
+#include <Transaction>
+#include <Details>
+
+/**
+ * Shows the updates PackageKit has staged to be installed
+ * offline, and whether that happens on the next reboot
+ */
+class OfflineUpdate : public KMessageWidget
+{
+    Q_OBJECT
+public:
+    explicit OfflineUpdate(QWidget *parent = nullptr);
+    ~OfflineUpdate() override;
+
+public Q_SLOTS:
+    void refresh();
+
+private Q_SLOTS:
+    void installOnReboot();
+    void cancelOfflineUpdate();
+    void details(const PackageKit::Details &details);
+    void detailsFinished();
+
+private:
+    void updateText();
+
+    QAction *m_installAction;
+    QAction *m_cancelAction;
+    PackageKit::Transaction *m_detailsT = nullptr;
+    int m_count = 0;
+    qulonglong m_size = 0;
+};
+
+#endif
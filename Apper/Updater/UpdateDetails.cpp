@@ -19,6 +19,7 @@
  ***************************************************************************/
 
 #include "UpdateDetails.h"
+#include "ChangelogRenderer.h"
 
 #include <Daemon>
 #include <PkStrings.h>
@@ -29,6 +30,8 @@
 #include <KFormat>
 
 #include <QAbstractAnimation>
+#include <QDesktopServices>
+#include <QScrollBar>
 #include <QGraphicsOpacityEffect>
 #include <QStringBuilder>
 #include <KIconLoader>
@@ -38,6 +41,14 @@
 #include <QLoggingCategory>
 
 #define FINAL_HEIGHT 160
+// Small enough to not hold the backend lock for long
+#define FETCH_CHUNK_SIZE 50
+// Longer texts (some kernel changelogs have hundreds of KiB) are
+// only rendered in full when the user asks for them
+#define RENDER_MAX_LENGTH (32 * 1024)
+#define SHOW_FULL_TEXT_URL "apper:show-full-text"
+// Rendered descriptions kept, in KiB
+#define RENDER_CACHE_SIZE 2048
 
 Q_DECLARE_LOGGING_CATEGORY(APPER)
 
@@ -68,6 +79,8 @@ UpdateDetails::UpdateDetails(QWidget *parent)
     m_fadeDetails->setEndValue(qreal(1));
     connect(m_fadeDetails, &QPropertyAnimation::finished, this, &UpdateDetails::display);
 
+    descriptionKTB->setOpenLinks(false);
+    connect(descriptionKTB, &QTextBrowser::anchorClicked, this, &UpdateDetails::linkClicked);
 
     auto anim1 = new QPropertyAnimation(this, "maximumSize", this);
     anim1->setDuration(500);
@@ -85,6 +98,7 @@ UpdateDetails::UpdateDetails(QWidget *parent)
     m_expandPanel->addAnimation(anim2);
     connect(m_expandPanel, &QParallelAnimationGroup::finished, this, &UpdateDetails::display);
 
+    m_rendered.setMaxCost(RENDER_CACHE_SIZE);
 }
 
 UpdateDetails::~UpdateDetails()
@@ -103,11 +117,17 @@ void UpdateDetails::setPackage(const QString &packageId, Transaction::Info updat
     if (m_transaction) {
         disconnect(m_transaction, &Transaction::updateDetail, this, &UpdateDetails::updateDetail);
         disconnect(m_transaction, &Transaction::finished, this, &UpdateDetails::display);
+        m_transaction = nullptr;
     }
 
-    m_transaction = Daemon::getUpdateDetail(m_packageId);
-    connect(m_transaction, &Transaction::updateDetail, this, &UpdateDetails::updateDetail);
-    connect(m_transaction, &Transaction::finished, this, &UpdateDetails::display);
+    auto it = m_details.constFind(m_packageId);
+    if (it != m_details.constEnd()) {
+        m_currentDescription = renderDetail(m_packageId, it.value());
+    } else {
+        m_transaction = Daemon::getUpdateDetail(m_packageId);
+        connect(m_transaction, &Transaction::updateDetail, this, &UpdateDetails::updateDetail);
+        connect(m_transaction, &Transaction::finished, this, &UpdateDetails::display);
+    }
 
     if (maximumSize().height() == 0) {
         // Expand the panel
@@ -118,7 +138,65 @@ void UpdateDetails::setPackage(const QString &packageId, Transaction::Info updat
         m_fadeDetails->setDirection(QAbstractAnimation::Backward);
         m_fadeDetails->start();
     }
-    m_busySeq->start();
+
+    if (m_transaction) {
+        m_busySeq->start();
+    } else {
+        display();
+    }
+}
+
+void UpdateDetails::fetchDetails(const QStringList &packageIds)
+{
+    clearDetails();
+    m_fetchQueue = packageIds;
+    fetchNextChunk();
+}
+
+void UpdateDetails::clearDetails()
+{
+    if (m_fetchTransaction) {
+        // Don't keep the backend busy with details nobody will see
+        disconnect(m_fetchTransaction, nullptr, this, nullptr);
+        m_fetchTransaction->cancel();
+        m_fetchTransaction = nullptr;
+    }
+    m_fetchQueue.clear();
+    m_details.clear();
+    m_rendered.clear();
+    m_fullText.clear();
+}
+
+bool UpdateDetails::hasDetail(const QString &packageId) const
+{
+    return m_details.contains(packageId);
+}
+
+UpdateDetails::UpdateDetail UpdateDetails::detail(const QString &packageId) const
+{
+    return m_details.value(packageId);
+}
+
+void UpdateDetails::fetchNextChunk()
+{
+    m_fetchTransaction = nullptr;
+
+    QStringList chunk;
+    while (chunk.size() < FETCH_CHUNK_SIZE && !m_fetchQueue.isEmpty()) {
+        const QString packageId = m_fetchQueue.takeFirst();
+        // The user might have clicked on it already
+        if (!m_details.contains(packageId)) {
+            chunk << packageId;
+        }
+    }
+
+    if (chunk.isEmpty()) {
+        return;
+    }
+
+    m_fetchTransaction = Daemon::getUpdateDetail(chunk);
+    connect(m_fetchTransaction, &Transaction::updateDetail, this, &UpdateDetails::updateDetail);
+    connect(m_fetchTransaction, &Transaction::finished, this, &UpdateDetails::fetchNextChunk);
 }
 
 void UpdateDetails::hide()
@@ -173,6 +251,41 @@ void UpdateDetails::updateDetail(const QString &packageID,
                                  PackageKit::Transaction::UpdateState state,
                                  const QDateTime &issued,
                                  const QDateTime &updated)
+{
+    UpdateDetail detail;
+    detail.updates = updates;
+    detail.obsoletes = obsoletes;
+    detail.vendorUrls = vendorUrls;
+    detail.bugzillaUrls = bugzillaUrls;
+    detail.cveUrls = cveUrls;
+    detail.restart = restart;
+    detail.updateText = updateText;
+    detail.changelog = changelog;
+    detail.state = state;
+    detail.issued = issued;
+    detail.updated = updated;
+    m_details[packageID] = detail;
+    m_rendered.remove(packageID);
+
+    if (packageID == m_packageId && m_transaction) {
+        m_currentDescription = renderDetail(packageID, detail);
+        m_busySeq->stop();
+    }
+}
+
+QString UpdateDetails::renderDetail(const QString &packageID, const UpdateDetail &detail)
+{
+    QString *rendered = m_rendered.object(packageID);
+    if (rendered) {
+        return *rendered;
+    }
+
+    const QString description = formatDetail(packageID, detail);
+    m_rendered.insert(packageID, new QString(description), 1 + description.size() / 1024);
+    return description;
+}
+
+QString UpdateDetails::formatDetail(const QString &packageID, const UpdateDetail &detail) const
 {
     //format and show description
     QString description;
@@ -201,107 +314,111 @@ void UpdateDetails::updateDetail(const QString &packageID,
     }
 
     // Issued and Updated
-    if (!issued.isNull() && !updated.isNull()) {
+    if (!detail.issued.isNull() && !detail.updated.isNull()) {
         description += QLatin1String("<p>") +
                        i18n("This notification was issued on %1 and last updated on %2.",
-                            QLocale::system().toString(issued, QLocale::ShortFormat),
-                            QLocale::system().toString(updated, QLocale::ShortFormat)) +
+                            QLocale::system().toString(detail.issued, QLocale::ShortFormat),
+                            QLocale::system().toString(detail.updated, QLocale::ShortFormat)) +
                        QLatin1String("</p>");
-    } else if (!issued.isNull()) {
+    } else if (!detail.issued.isNull()) {
         description += QLatin1String("<p>") +
                        i18n("This notification was issued on %1.",
-                            QLocale::system().toString(issued, QLocale::ShortFormat)) +
+                            QLocale::system().toString(detail.issued, QLocale::ShortFormat)) +
                        QLatin1String("</p>");
     }
 
     // Description
-    if (!updateText.isEmpty()) {
-        QString _updateText = updateText;
-        _updateText.replace(QLatin1Char('\n'), QLatin1String("<br/>"));
-        _updateText.replace(QLatin1Char(' '), QLatin1String("&nbsp;"));
-        description += QLatin1String("<p>") + _updateText + QLatin1String("</p>");
+    bool truncated = false;
+    const int maxLength = m_fullText.contains(packageID) ? 0 : RENDER_MAX_LENGTH;
+    if (!detail.updateText.isEmpty()) {
+        description += QLatin1String("<p>") +
+                       ChangelogRenderer::toHtml(detail.updateText, maxLength, &truncated) +
+                       QLatin1String("</p>");
     }
 
     // links
     //  Vendor
-    if (!vendorUrls.isEmpty()) {
+    if (!detail.vendorUrls.isEmpty()) {
         description += QLatin1String("<p>") +
                        i18np("For more information about this update please visit this website:",
                              "For more information about this update please visit these websites:",
-                             vendorUrls.size()) + QLatin1String("<br/>") +
-                       getLinkList(vendorUrls) +
+                             detail.vendorUrls.size()) + QLatin1String("<br/>") +
+                       getLinkList(detail.vendorUrls) +
                        QLatin1String("</p>");
     }
 
     //  Bugzilla
-    if (!bugzillaUrls.isEmpty()) {
+    if (!detail.bugzillaUrls.isEmpty()) {
         description += QLatin1String("<p>") +
                        i18np("For more information about bugs fixed by this update please visit this website:",
                              "For more information about bugs fixed by this update please visit these websites:",
-                             bugzillaUrls.size()) + QLatin1String("<br>") +
-                       getLinkList(bugzillaUrls) +
+                             detail.bugzillaUrls.size()) + QLatin1String("<br>") +
+                       getLinkList(detail.bugzillaUrls) +
                        QLatin1String("</p>");
     }
 
     //  CVE
-    if (!cveUrls.isEmpty()) {
+    if (!detail.cveUrls.isEmpty()) {
         description += QLatin1String("<p>") +
                        i18np("For more information about this security update please visit this website:",
                              "For more information about this security update please visit these websites:",
-                             cveUrls.size()) + QLatin1String("<br>") +
-                       getLinkList(cveUrls) +
+                             detail.cveUrls.size()) + QLatin1String("<br>") +
+                       getLinkList(detail.cveUrls) +
                        QLatin1String("</p>");
     }
 
     // Notice (about the need for a reboot)
-    if (restart == Transaction::RestartSystem) {
+    if (detail.restart == Transaction::RestartSystem) {
         description += QLatin1String("<p>") +
                        i18n("The computer will have to be restarted after the update for the changes to take effect.") +
                        QLatin1String("</p>");
-    } else if (restart == Transaction::RestartSession) {
+    } else if (detail.restart == Transaction::RestartSession) {
         description += QLatin1String("<p>") +
                        i18n("You will need to log out and back in after the update for the changes to take effect.") +
                        QLatin1String("</p>");
     }
 
     // State
-    if (state == Transaction::UpdateStateUnstable) {
+    if (detail.state == Transaction::UpdateStateUnstable) {
         description += QLatin1String("<p>") +
                        i18n("The classification of this update is unstable which means it is not designed for production use.") +
                        QLatin1String("</p>");
-    } else if (state == Transaction::UpdateStateTesting) {
+    } else if (detail.state == Transaction::UpdateStateTesting) {
         description += QLatin1String("<p>") +
                        i18n("This is a test update, and is not designed for normal use. Please report any problems or regressions you encounter.") +
                        QLatin1String("</p>");
     }
 
     // only show changelog if we didn't have any update text
-    if (updateText.isEmpty() && !changelog.isEmpty()) {
-        QString _changelog = changelog;
-        _changelog.replace(QLatin1Char('\n'), QLatin1String("<br/>"));
-        _changelog.replace(QLatin1Char(' '), QLatin1String("&nbsp;"));
+    if (detail.updateText.isEmpty() && !detail.changelog.isEmpty()) {
         description += QLatin1String("<p>") +
                        i18n("The developer logs will be shown as no description is available for this update:") +
                        QLatin1String("<br>") +
-                       _changelog +
+                       ChangelogRenderer::toHtml(detail.changelog, maxLength, &truncated) +
                        QLatin1String("</p>");
     }
 
+    if (truncated) {
+        description += QLatin1String("<p><a href=\"" SHOW_FULL_TEXT_URL "\">") +
+                       i18n("Show full changelog") +
+                       QLatin1String("</a></p>");
+    }
+
     // Updates (lists of packages that are updated)
-    if (!updates.isEmpty()) {
+    if (!detail.updates.isEmpty()) {
         description += QLatin1String("<p>") + i18n("Updates:") + QLatin1String("<br>");
         QStringList _updates;
-        for (const QString &pid : updates) {
+        for (const QString &pid : detail.updates) {
              _updates += QString::fromUtf8("\xE2\x80\xA2 ") + Transaction::packageName(pid) + QLatin1String(" - ") + Transaction::packageVersion(pid);
         }
         description += _updates.join(QLatin1String("<br>")) + QLatin1String("</p>");
     }
 
     // Obsoletes (lists of packages that are obsoleted)
-    if (obsoletes.size()) {
+    if (detail.obsoletes.size()) {
         description += QLatin1String("<p></b>") + i18n("Obsoletes:") + QLatin1String("</b><br/>");
         QStringList _obsoletes;
-        for (const QString &pid : obsoletes) {
+        for (const QString &pid : detail.obsoletes) {
              _obsoletes += QString::fromUtf8("\xE2\x80\xA2 ") + Transaction::packageName(pid) + QLatin1String(" - ") + Transaction::packageVersion(pid);
         }
         description += _obsoletes.join(QLatin1String("<br>/")) + QLatin1String("</p>");
@@ -312,8 +429,7 @@ void UpdateDetails::updateDetail(const QString &packageID,
          description += QLatin1String("<p>") + i18n("Repository: %1", Transaction::packageData(packageID)) + QLatin1String("</p>");
     }
 
-    m_currentDescription = description;
-    m_busySeq->stop();
+    return description;
 }
 
 QString UpdateDetails::getLinkList(const QStringList &urls) const
@@ -328,6 +444,27 @@ QString UpdateDetails::getLinkList(const QStringList &urls) const
     return ret;
 }
 
+void UpdateDetails::linkClicked(const QUrl &url)
+{
+    if (url != QUrl(QLatin1String(SHOW_FULL_TEXT_URL))) {
+        QDesktopServices::openUrl(url);
+        return;
+    }
+
+    auto it = m_details.constFind(m_packageId);
+    if (it == m_details.constEnd()) {
+        return;
+    }
+
+    // Render the rest now, keeping the user where they were reading
+    m_fullText.insert(m_packageId);
+    m_rendered.remove(m_packageId);
+    m_currentDescription = renderDetail(m_packageId, it.value());
+    const int position = descriptionKTB->verticalScrollBar()->value();
+    descriptionKTB->setHtml(m_currentDescription);
+    descriptionKTB->verticalScrollBar()->setValue(position);
+}
+
 void UpdateDetails::updateDetailFinished()
 {
     if (descriptionKTB->document()->toPlainText().isEmpty()) {
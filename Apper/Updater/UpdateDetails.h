@@ -25,6 +25,11 @@
 
 #include <QPropertyAnimation>
 #include <QParallelAnimationGroup>
+#include <QDateTime>
+#include <QHash>
+#include <QSet>
+#include <QUrl>
+#include <QCache>
 
 #include <Transaction>
 
@@ -36,11 +41,34 @@ class UpdateDetails : public QWidget, Ui::UpdateDetails
 {
 Q_OBJECT
 public:
+    struct UpdateDetail {
+        QStringList updates;
+        QStringList obsoletes;
+        QStringList vendorUrls;
+        QStringList bugzillaUrls;
+        QStringList cveUrls;
+        Transaction::Restart restart = Transaction::RestartUnknown;
+        QString updateText;
+        QString changelog;
+        Transaction::UpdateState state = Transaction::UpdateStateUnknown;
+        QDateTime issued;
+        QDateTime updated;
+    };
+
     explicit UpdateDetails(QWidget *parent = nullptr);
     ~UpdateDetails() override;
 
     void setPackage(const QString &packageId, Transaction::Info updateInfo);
 
+    /**
+     * Fetches the update details of all packageIds in the background,
+     * a few packages per transaction, replacing the cached ones
+     */
+    void fetchDetails(const QStringList &packageIds);
+    void clearDetails();
+    bool hasDetail(const QString &packageId) const;
+    UpdateDetail detail(const QString &packageId) const;
+
 public Q_SLOTS:
     void hide();
 
@@ -59,13 +87,23 @@ private Q_SLOTS:
                       const QDateTime &updated);
     void updateDetailFinished();
     void display();
+    void fetchNextChunk();
+    void linkClicked(const QUrl &url);
 
 private:
     QString getLinkList(const QStringList &urls) const;
+    QString renderDetail(const QString &packageID, const UpdateDetail &detail);
+    QString formatDetail(const QString &packageID, const UpdateDetail &detail) const;
 
     bool m_show = false;
     QString m_packageId;
     Transaction *m_transaction = nullptr;
+    Transaction *m_fetchTransaction = nullptr;
+    QStringList m_fetchQueue;
+    QHash<QString, UpdateDetail> m_details;
+    QCache<QString, QString> m_rendered;
+    // Packages whose long texts the user asked to see in full
+    QSet<QString> m_fullText;
     QString m_currentDescription;
     Transaction::Info m_updateInfo;
     KPixmapSequenceOverlayPainter *m_busySeq;
@@ -39,6 +39,11 @@
 #include <ApplicationSortFilterModel.h>
 
 #include <QDBusConnection>
+#include <QDBusMessage>
+#include <QDBusPendingCallWatcher>
+#include <QDBusPendingReply>
+
+#include <UpdateItem.h>
 
 #include <KConfig>
 #include <KFormat>
@@ -96,6 +101,7 @@ Updater::Updater(Transaction::Roles roles, QWidget *parent) :
 
     // hide distro Upgrade container and line
     ui->distroUpgrade->hide();
+    ui->offlineUpdate->hide();
 
     KConfig config(QLatin1String("apper"));
     KConfigGroup viewGroup(&config, "UpdateView");
@@ -134,6 +140,15 @@ Updater::Updater(Transaction::Roles roles, QWidget *parent) :
     m_showPackageSize->setCheckable(true);
     connect(m_showPackageSize, &QAction::toggled, this, &Updater::showSizes);
     m_showPackageSize->setChecked(viewGroup.readEntry("ShowSizes", true));
+
+    // apperd tells us when its update list changed
+    registerUpdateItemTypes();
+    QDBusConnection::sessionBus().connect(QLatin1String("org.kde.apperd"),
+                                          QLatin1String("/"),
+                                          QLatin1String("org.kde.apperd"),
+                                          QLatin1String("UpdatesChanged"),
+                                          this,
+                                          SLOT(apperdUpdatesChanged(uint)));
 }
 
 Updater::~Updater()
@@ -265,8 +280,15 @@ void Updater::load()
 void Updater::getUpdatesFinished()
 {
     m_updatesT = nullptr;
+    m_resumePackages.clear();
     m_updatesModel->clearSelectedNotPresent();
     checkEnableUpdateButton();
+
+    // Fetch the update details while the user is looking
+    // at the list so that clicking on an update is instant
+    if (m_roles & Transaction::RoleGetUpdateDetail) {
+        ui->updateDetails->fetchDetails(m_updatesModel->packageIDs());
+    }
     if (m_updatesModel->rowCount() == 0) {
         // Set the info page
         ui->stackedWidget->setCurrentIndex(1);
@@ -282,9 +304,14 @@ QStringList Updater::packagesToUpdate() const
     return m_updatesModel->selectedPackagesToInstall();
 }
 
+void Updater::setResumePackages(const QStringList &packageIDs)
+{
+    m_resumePackages = packageIDs.toSet();
+}
+
 void Updater::getUpdates()
 {
-    if (m_updatesT) {
+    if (m_updatesT || m_updatesCall) {
         // There is a getUpdates running ignore this call
         return;
     }
@@ -297,8 +324,74 @@ void Updater::getUpdates()
     ui->packageView->setHeaderHidden(true);
     m_updatesModel->clear();
     ui->updateDetails->hide();
+    ui->updateDetails->clearDetails();
+    m_busySeq->start();
+
+    // apperd already keeps the update list, only ask
+    // PackageKit directly if it is not running
+    QDBusMessage message;
+    message = QDBusMessage::createMethodCall(QLatin1String("org.kde.apperd"),
+                                             QLatin1String("/"),
+                                             QLatin1String("org.kde.apperd"),
+                                             QLatin1String("GetUpdates"));
+    m_updatesCall = new QDBusPendingCallWatcher(QDBusConnection::sessionBus().asyncCall(message), this);
+    connect(m_updatesCall, &QDBusPendingCallWatcher::finished, this, &Updater::apperdUpdatesFinished);
+
+    // Hide the distribution upgrade information
+    ui->distroUpgrade->animatedHide();
+
+    // Updates staged to be installed offline
+    ui->offlineUpdate->refresh();
+
+    if (m_roles & Transaction::RoleGetDistroUpgrades) {
+        // Check for distribution Upgrades
+        Transaction *t = Daemon::getDistroUpgrades();
+        connect(t, &Transaction::distroUpgrade, this, &Updater::distroUpgrade);
+    }
+}
+
+void Updater::apperdUpdatesChanged(uint generation)
+{
+    if (generation != m_generation) {
+        m_generation = generation;
+        getUpdates();
+    }
+}
+
+void Updater::apperdUpdatesFinished(QDBusPendingCallWatcher *call)
+{
+    m_updatesCall = nullptr;
+    call->deleteLater();
+
+    QDBusPendingReply<UpdateItemList, uint> reply = *call;
+    if (reply.isError()) {
+        qCDebug(APPER) << "apperd did not list the updates" << reply.error().message();
+        getUpdatesFromPackageKit();
+        return;
+    }
+
+    // Only a different generation is worth reloading for
+    m_generation = reply.argumentAt<1>();
+    const UpdateItemList updates = reply.argumentAt<0>();
+    for (const UpdateItem &item : updates) {
+        addUpdate(static_cast<Transaction::Info>(item.info), item.packageID, item.summary);
+    }
+    m_busySeq->stop();
+    m_updatesModel->finished();
+
+    // This is required to estimate download size
+    m_updatesModel->fetchSizes();
+
+    if (m_showPackageCurrentVersion->isChecked()) {
+        m_updatesModel->fetchCurrentVersions();
+    }
+    getUpdatesFinished();
+}
+
+void Updater::getUpdatesFromPackageKit()
+{
     m_updatesT = Daemon::getUpdates();
-    connect(m_updatesT, &Transaction::package, m_updatesModel, &PackageModel::addSelectedPackage);
+    connect(m_updatesT, &Transaction::package, this, &Updater::addUpdate);
     connect(m_updatesT, &Transaction::errorCode, this, &Updater::errorCode);
     connect(m_updatesT, &Transaction::finished, m_busySeq, &KPixmapSequenceOverlayPainter::stop);
     connect(m_updatesT, &Transaction::finished, m_updatesModel, &PackageModel::finished);
@@ -310,17 +403,12 @@ void Updater::getUpdates()
         connect(m_updatesT, &Transaction::finished, m_updatesModel, &PackageModel::fetchCurrentVersions);
     }
     connect(m_updatesT, &Transaction::finished, this, &Updater::getUpdatesFinished);
-    m_busySeq->start();
-
-    // Hide the distribution upgrade information
-    ui->distroUpgrade->animatedHide();
+}
 
-    if (m_roles & Transaction::RoleGetDistroUpgrades) {
-        // Check for distribution Upgrades
-        Transaction *t = Daemon::getDistroUpgrades();
-        connect(m_updatesT, &Transaction::distroUpgrade, this, &Updater::distroUpgrade);
-        connect(m_updatesT, &Transaction::finished, t, &Transaction::deleteLater);
-    }
+void Updater::addUpdate(Transaction::Info info, const QString &packageID, const QString &summary)
+{
+    bool selected = m_resumePackages.isEmpty() || m_resumePackages.contains(packageID);
+    m_updatesModel->addPackage(info, packageID, summary, selected);
 }
 
 void Updater::on_packageView_customContextMenuRequested(const QPoint &pos)
@@ -23,6 +23,7 @@
 
 #include <QWidget>
 #include <QModelIndex>
+#include <QSet>
 
 #include <KPixmapSequenceOverlayPainter>
 
@@ -30,6 +31,8 @@
 
 using namespace PackageKit;
 
+class QDBusPendingCallWatcher;
+
 namespace Ui {
     class Updater;
 }
@@ -46,6 +49,11 @@ public:
 
     bool hasChanges() const;
     QStringList packagesToUpdate() const;
+    /**
+     * Only these are checked the next time the updates
+     * are listed, what a failed batched update left
+     */
+    void setResumePackages(const QStringList &packageIDs);
 
 Q_SIGNALS:
     void installUpdates();
@@ -64,6 +72,8 @@ private Q_SLOTS:
     void distroUpgrade(PackageKit::Transaction::DistroUpgrade type, const QString &name, const QString &description);
 
     void getUpdatesFinished();
+    void apperdUpdatesChanged(uint generation);
+    void apperdUpdatesFinished(QDBusPendingCallWatcher *call);
 
     void on_packageView_clicked(const QModelIndex &index);
 
@@ -78,6 +88,9 @@ private Q_SLOTS:
     void updatePallete();
 
 private:
+    void getUpdatesFromPackageKit();
+    void addUpdate(PackageKit::Transaction::Info info, const QString &packageID, const QString &summary);
+
     Ui::Updater          *ui;
     Transaction::Roles    m_roles;
     bool                  m_selected = true;
@@ -90,6 +103,9 @@ private:
     QAction              *m_showPackageOrigin;
     QAction              *m_showPackageSize;
     Transaction          *m_updatesT = nullptr;
+    QDBusPendingCallWatcher *m_updatesCall = nullptr;
+    uint                  m_generation = 0;
+    QSet<QString>         m_resumePackages;
     KPixmapSequenceOverlayPainter *m_busySeq;
 };
 
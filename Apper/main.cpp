@@ -21,8 +21,11 @@
 #include "Apper.h"
 #include <config.h>
 
+#include <QDBusArgument>
 #include <QDBusMessage>
 #include <QDBusConnection>
+#include <QDateTime>
+#include <QTextStream>
 
 #include <QLoggingCategory>
 
@@ -33,8 +36,90 @@
 #include <QIcon>
 #include <QDir>
 
+#ifdef HAVE_APPSTREAM
+#include <AppStream.h>
+#endif
+
+static QVariantMap toMap(const QVariant &value)
+{
+    // Nested dicts arrive unmarshalled
+    if (value.canConvert<QDBusArgument>()) {
+        return qdbus_cast<QVariantMap>(value.value<QDBusArgument>());
+    }
+    return value.toMap();
+}
+
+static QVariantList toList(const QVariant &value)
+{
+    if (value.canConvert<QDBusArgument>()) {
+        return qdbus_cast<QVariantList>(value.value<QDBusArgument>());
+    }
+    return value.toList();
+}
+
+static int printTransactionStats()
+{
+    QTextStream out(stdout);
+    QDBusMessage message;
+    message = QDBusMessage::createMethodCall(QLatin1String("org.kde.apperd"),
+                                             QLatin1String("/"),
+                                             QLatin1String("org.kde.apperd"),
+                                             QLatin1String("Stats"));
+    QDBusMessage reply = QDBusConnection::sessionBus().call(message);
+    if (reply.type() != QDBusMessage::ReplyMessage || reply.arguments().isEmpty()) {
+        QTextStream(stderr) << "Failed to get the transaction stats from apperd: " << reply.errorMessage() << endl;
+        return 1;
+    }
+
+    const QVariantMap stats = toMap(reply.arguments().first());
+    const QVariantList buckets = toList(stats[QLatin1String("buckets")]);
+    const QDateTime since = QDateTime::fromMSecsSinceEpoch(stats[QLatin1String("since")].toLongLong() * 1000);
+    out << stats[QLatin1String("samples")].toUInt() << " transactions since " << since.toString(Qt::ISODate) << endl;
+
+    out << qSetFieldWidth(12) << left << "ms" << right;
+    for (const QVariant &bound : buckets) {
+        out << QLatin1String("<") + bound.toString();
+    }
+    out << QLatin1String(">") + buckets.value(buckets.size() - 1).toString() << reset << endl;
+
+    const QVariantMap roles = toMap(stats[QLatin1String("roles")]);
+    for (auto it = roles.constBegin(); it != roles.constEnd(); ++it) {
+        const QVariantMap role = toMap(it.value());
+        out << endl << it.key() << ": "
+            << role[QLatin1String("count")].toUInt() << " runs, "
+            << role[QLatin1String("failed")].toUInt() << " failed, "
+            << role[QLatin1String("bytes")].toULongLong() << " bytes, "
+            << role[QLatin1String("packages")].toULongLong() << " packages" << endl;
+
+        const QStringList histograms = {
+            QLatin1String("queueWait"),
+            QLatin1String("download"),
+            QLatin1String("runtime")
+        };
+        for (const QString &histogram : histograms) {
+            out << qSetFieldWidth(12) << left << histogram << right;
+            const QVariantList counts = toList(role[histogram]);
+            for (const QVariant &count : counts) {
+                out << count.toUInt();
+            }
+            out << reset << endl;
+        }
+    }
+
+    return 0;
+}
+
 int main(int argc, char **argv)
 {
+    // Dumps apperd's transaction timings for scripts, this
+    // must not start or activate the unique UI instance
+    for (int i = 1; i < argc; ++i) {
+        if (qstrcmp(argv[i], "--transaction-stats") == 0) {
+            QCoreApplication app(argc, argv);
+            return printTransactionStats();
+        }
+    }
+
     Apper app(argc, argv);
     QApplication::setWindowIcon(QIcon::fromTheme(QLatin1String("system-software-install")));
 
@@ -51,6 +136,12 @@ int main(int argc, char **argv)
 
     KAboutData::setApplicationData(aboutData);
 
+#ifdef HAVE_APPSTREAM
+    // Start loading the AppStream pool in the background
+    // so it is ready by the time the first search finishes
+    AppStreamHelper::instance();
+#endif
+
     app.activate(app.arguments(), QDir::currentPath());
 
     return app.exec();
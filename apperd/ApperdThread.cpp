@@ -25,6 +25,7 @@
 #include "TransactionWatcher.h"
 #include "DBusInterface.h"
 #include "RebootListener.h"
+#include "Watchdog.h"
 
 #include <Enum.h>
 #include <Daemon>
@@ -35,11 +36,11 @@
 #include <KDirWatch>
 #include <KProtocolManager>
 #include <KLocalizedString>
-//#include <Solid/PowerManagement>
+#include <Solid/PowerManagement>
 #include <KFormat>
 
 #include <QtDBus/QDBusConnection>
-#include <QtDBus/QDBusReply>
+#include <QtDBus/QDBusPendingReply>
 #include <QDBusServiceWatcher>
 
 #include <limits.h>
@@ -48,8 +49,13 @@
 
 Q_DECLARE_LOGGING_CATEGORY(APPER_DAEMON)
 
-#define FIVE_MIN 360000
 #define ONE_MIN   72000
+// When the system wasn't ready to refresh, try again later
+#define REFRESH_RETRY_DELAY (30 * 60)
+#define DISTRO_UPGRADE_INTERVAL (24 * 60 * 60)
+#define REBOOT_CHECK_DELAY (2 * 60)
+// Provides the power save status Solid reports
+#define POWER_MANAGEMENT_SERVICE "org.freedesktop.PowerManagement"
 
 /*
  * What we need:
@@ -60,7 +66,6 @@ Q_DECLARE_LOGGING_CATEGORY(APPER_DAEMON)
  */
 
 using namespace PackageKit;
-//using namespace Solid;
 
 ApperdThread::ApperdThread(QObject *parent) :
     QObject(parent),
@@ -75,15 +80,37 @@ ApperdThread::~ApperdThread()
 
 void ApperdThread::init()
 {
-//    connect(PowerManagement::notifier(), SIGNAL(appShouldConserveResourcesChanged(bool)),
-//            this, SLOT(appShouldConserveResourcesChanged()));
+    connect(Solid::PowerManagement::notifier(), &Solid::PowerManagement::Notifier::appShouldConserveResourcesChanged,
+            this, &ApperdThread::appShouldConserveResourcesChanged);
+    // Solid can only tell we are on battery if something provides the
+    // power state, keep track of it without asking the bus each time
+    auto powerWatcher = new QDBusServiceWatcher(QLatin1String(POWER_MANAGEMENT_SERVICE),
+                                                QDBusConnection::sessionBus(),
+                                                QDBusServiceWatcher::WatchForOwnerChange,
+                                                this);
+    connect(powerWatcher, &QDBusServiceWatcher::serviceOwnerChanged, this,
+            [this] (const QString &service, const QString &oldOwner, const QString &newOwner) {
+        Q_UNUSED(service)
+        Q_UNUSED(oldOwner)
+        m_hasPowerManagement = !newOwner.isEmpty();
+        appShouldConserveResourcesChanged();
+    });
+    auto powerCall = nameHasOwner(QLatin1String(POWER_MANAGEMENT_SERVICE), QDBusConnection::sessionBus(), this);
+    connect(powerCall, &QDBusPendingCallWatcher::finished, this, [this] (QDBusPendingCallWatcher *call) {
+        QDBusPendingReply<bool> reply = *call;
+        // The watcher might have told us already
+        m_hasPowerManagement = m_hasPowerManagement || (reply.isValid() && reply.value());
+        if (!m_hasPowerManagement) {
+            qCWarning(APPER_DAEMON) << POWER_MANAGEMENT_SERVICE
+                                    << "is not running, updates can't be deferred while on battery";
+        }
+        call->deleteLater();
+    });
 
-    // This timer keeps polling to see if it has
-    // to refresh the cache
-    m_qtimer = new QTimer(this);
-    m_qtimer->setInterval(FIVE_MIN);
-    connect(m_qtimer, &QTimer::timeout, this, &ApperdThread::poll);
-    m_qtimer->start();
+    // Runs the periodic checks when they are due, instead
+    // of waking up every few minutes to see if they are
+    m_scheduler = new Scheduler(this);
+    connect(m_scheduler, &Scheduler::due, this, &ApperdThread::taskDue);
 
     //check if any changes to the file occour
     //this also prevents from reading when a checkUpdate happens
@@ -110,8 +137,16 @@ void ApperdThread::init()
 
     m_refreshCache = new RefreshCacheTask(this);
     connect(m_interface, &DBusInterface::refreshCache, m_refreshCache, &RefreshCacheTask::refreshCache);
+    connect(m_refreshCache, &RefreshCacheTask::refreshed, this, [this] () {
+        // The next update list tells if it found something
+        m_refreshOutcomePending = true;
+    });
+    m_interface->setRefreshPolicy(&m_refreshPolicy);
 
     m_updater = new Updater(this);
+    connect(m_updater, &Updater::updatesListed, m_interface, &DBusInterface::setUpdates);
+    connect(m_updater, &Updater::updatesListed, this, &ApperdThread::updatesListed);
+    connect(m_interface, &DBusInterface::prepareOfflineUpdate, m_updater, &Updater::prepareOfflineUpdate);
 
     m_distroUpgrade = new DistroUpgrade(this);
 
@@ -125,58 +160,109 @@ void ApperdThread::init()
                                            this);
     connect(watcher, &QDBusServiceWatcher::serviceRegistered, this, &ApperdThread::setProxy);
 
-    // if PackageKit is running check to see if there are running transactons already
-    bool packagekitIsRunning = nameHasOwner(QLatin1String("org.freedesktop.PackageKit"),
-                                            QDBusConnection::systemBus());
-
-    m_transactionWatcher = new TransactionWatcher(packagekitIsRunning, this);
+    m_transactionWatcher = new TransactionWatcher(this);
+    m_interface->setTransactionStats(m_transactionWatcher->stats());
 
     // connect the watch transaction coming from the updater icon to our watcher
     connect(m_interface, &DBusInterface::watchTransaction, m_transactionWatcher, &TransactionWatcher::watchTransactionInteractive);
 
      // listen to Debian/Apt reboot signals from other sources (apt)
     connect(m_AptRebootListener, &AptRebootListener::requestReboot, m_transactionWatcher, &TransactionWatcher::showRebootNotificationApt);
-    QTimer::singleShot(2 /*minutes*/ * 60 /*seconds*/ * 1000 /*msec*/, m_AptRebootListener, SLOT(checkForReboot()));
+    m_scheduler->schedule(Scheduler::TaskRebootCheck, QDateTime::currentDateTime().addSecs(REBOOT_CHECK_DELAY));
 
-    if (packagekitIsRunning) {
-        // PackageKit is running set the session Proxy
-        setProxy();
+    // Reports how long the calls above and everything
+    // after them keep kded's main thread busy
+    m_interface->setWatchdog(new Watchdog(this));
 
-        // If packagekit is already running go check
-        // for updates
-        updatesChanged();
-    } else {
-        // Initial check for updates
-        QTimer::singleShot(ONE_MIN, this, SLOT(updatesChanged()));
+    // if PackageKit is running check to see if there are running transactons already
+    auto call = nameHasOwner(QLatin1String("org.freedesktop.PackageKit"),
+                             QDBusConnection::systemBus(),
+                             this);
+    connect(call, &QDBusPendingCallWatcher::finished, this, [this] (QDBusPendingCallWatcher *call) {
+        QDBusPendingReply<bool> reply = *call;
+        if (reply.isValid() && reply.value()) {
+            // PackageKit is running set the session Proxy
+            setProxy();
+
+            m_transactionWatcher->watchRunningTransactions();
+
+            // If packagekit is already running go check
+            // for updates
+            updatesChanged();
+        } else {
+            // Initial check for updates
+            QTimer::singleShot(ONE_MIN, this, SLOT(updatesChanged()));
+        }
+        call->deleteLater();
+    });
+}
+
+void ApperdThread::taskDue(Scheduler::Task task)
+{
+    switch (task) {
+    case Scheduler::TaskRefreshCache:
+    {
+        bool ignoreBattery = m_configs[QLatin1String(CFG_CHECK_UP_BATTERY)].value<bool>();
+        bool ignoreMobile = m_configs[QLatin1String(CFG_CHECK_UP_MOBILE)].value<bool>();
+        if (isSystemReady(ignoreBattery, ignoreMobile)) {
+            m_refreshCache->refreshCache();
+        }
+
+        // A successful refresh emits updatesChanged() which schedules
+        // the next one, this only matters if it fails or can't run now
+        m_scheduler->schedule(Scheduler::TaskRefreshCache,
+                              QDateTime::currentDateTime().addSecs(REFRESH_RETRY_DELAY));
+        break;
+    }
+    case Scheduler::TaskDistroUpgrade:
+        m_distroUpgrade->checkDistroUpgrades();
+        m_scheduler->schedule(Scheduler::TaskDistroUpgrade,
+                              QDateTime::currentDateTime().addSecs(DISTRO_UPGRADE_INTERVAL));
+        break;
+    case Scheduler::TaskRebootCheck:
+        m_AptRebootListener->checkForReboot();
+        break;
     }
 }
 
-// This is called every 5 minutes
-void ApperdThread::poll()
+void ApperdThread::scheduleRefreshCache()
 {
-    if (m_lastRefreshCache.isNull()) {
-        // This value wasn't set
-        // convert this to QDateTime
-        m_lastRefreshCache = getTimeSinceRefreshCache();
+    const uint interval = m_configs[QLatin1String(CFG_INTERVAL)].value<uint>();
+    if (interval == Enum::Never) {
+        m_scheduler->cancel(Scheduler::TaskRefreshCache);
+        return;
     }
 
-    // If check for updates is active
-    if (m_configs[QLatin1String(CFG_INTERVAL)].value<uint>() != Enum::Never) {
-        // Find out how many seconds passed since last refresh cache
-        qint64 msecsSinceLastRefresh = (QDateTime::currentDateTime().toMSecsSinceEpoch() - m_lastRefreshCache.toMSecsSinceEpoch()) / 1000;
+    auto call = new QDBusPendingCallWatcher(Daemon::global()->getTimeSinceAction(Transaction::RoleRefreshCache), this);
+    connect(call, &QDBusPendingCallWatcher::finished, this, [this] (QDBusPendingCallWatcher *call) {
+        call->deleteLater();
+
+        QDBusPendingReply<uint> reply = *call;
+        if (reply.isError()) {
+            qCWarning(APPER_DAEMON) << "Failed to get the time since the last refresh" << reply.error().message();
+            m_scheduler->schedule(Scheduler::TaskRefreshCache,
+                                  QDateTime::currentDateTime().addSecs(REFRESH_RETRY_DELAY));
+            return;
+        }
 
-        // If lastRefreshCache is null it means that the cache was never refreshed
-        if (m_lastRefreshCache.isNull() || msecsSinceLastRefresh > m_configs[QLatin1String(CFG_INTERVAL)].value<uint>()) {
-            bool ignoreBattery = m_configs[QLatin1String(CFG_CHECK_UP_BATTERY)].value<bool>();
-            bool ignoreMobile = m_configs[QLatin1String(CFG_CHECK_UP_MOBILE)].value<bool>();
-            if (isSystemReady(ignoreBattery, ignoreMobile)) {
-                m_refreshCache->refreshCache();
-            }
+        // The interval might have changed while we waited
+        if (m_configs[QLatin1String(CFG_INTERVAL)].value<uint>() == Enum::Never) {
+            return;
+        }
+        const uint interval = m_refreshPolicy.interval();
 
-            // Invalidate the last time the cache was refreshed
+        // When the refresh cache value was not yet defined UINT_MAX is returned
+        if (reply.value() == UINT_MAX) {
+            // The cache was never refreshed
             m_lastRefreshCache = QDateTime();
+            m_scheduler->schedule(Scheduler::TaskRefreshCache, QDateTime::currentDateTime());
+        } else {
+            // Calculate the last time the cache was refreshed by
+            // subtracting the seconds from the current time
+            m_lastRefreshCache = QDateTime::currentDateTime().addSecs(-qint64(reply.value()));
+            m_scheduler->schedule(Scheduler::TaskRefreshCache, m_lastRefreshCache.addSecs(interval));
         }
-    }
+    });
 }
 
 void ApperdThread::configFileChanged()
@@ -189,9 +275,20 @@ void ApperdThread::configFileChanged()
     m_configs[QLatin1String(CFG_INSTALL_UP_MOBILE)] = checkUpdateGroup.readEntry(CFG_INSTALL_UP_MOBILE, DEFAULT_INSTALL_UP_MOBILE);
     m_configs[QLatin1String(CFG_AUTO_UP)] = checkUpdateGroup.readEntry(CFG_AUTO_UP, Enum::AutoUpdateDefault);
     m_configs[QLatin1String(CFG_INTERVAL)] = checkUpdateGroup.readEntry(CFG_INTERVAL, Enum::TimeIntervalDefault);
+    m_configs[QLatin1String(CFG_MIN_INTERVAL)] = checkUpdateGroup.readEntry(CFG_MIN_INTERVAL, 0u);
+    m_configs[QLatin1String(CFG_MAX_INTERVAL)] = checkUpdateGroup.readEntry(CFG_MAX_INTERVAL, 0u);
     m_configs[QLatin1String(CFG_DISTRO_UPGRADE)] = checkUpdateGroup.readEntry(CFG_DISTRO_UPGRADE, Enum::DistroUpgradeDefault);
+    m_configs[QLatin1String(CFG_MAX_PRESSURE)] = checkUpdateGroup.readEntry(CFG_MAX_PRESSURE, DEFAULT_MAX_PRESSURE);
+    m_configs[QLatin1String(CFG_MAX_LOAD)] = checkUpdateGroup.readEntry(CFG_MAX_LOAD, DEFAULT_MAX_LOAD);
+    m_configs[QLatin1String(CFG_CALM_PERIOD)] = checkUpdateGroup.readEntry(CFG_CALM_PERIOD, DEFAULT_CALM_PERIOD);
+    m_configs[QLatin1String(CFG_DOWNLOAD_BUDGET)] = checkUpdateGroup.readEntry(CFG_DOWNLOAD_BUDGET, DEFAULT_DOWNLOAD_BUDGET);
+    m_configs[QLatin1String(CFG_PREPARE_OFFLINE)] = checkUpdateGroup.readEntry(CFG_PREPARE_OFFLINE, DEFAULT_PREPARE_OFFLINE);
     m_updater->setConfig(m_configs);
     m_distroUpgrade->setConfig(m_configs);
+    m_refreshPolicy.setBounds(m_configs[QLatin1String(CFG_INTERVAL)].value<uint>(),
+                              m_configs[QLatin1String(CFG_MIN_INTERVAL)].value<uint>(),
+                              m_configs[QLatin1String(CFG_MAX_INTERVAL)].value<uint>());
+    m_refreshCache->setCacheAge(m_refreshPolicy.cacheAge());
 
     KDirWatch *confWatch = qobject_cast<KDirWatch*>(sender());
     if (confWatch) {
@@ -228,41 +325,81 @@ void ApperdThread::setProxy()
     }
 
     // If we were called by the watcher it is because PackageKit is running
-    bool packagekitIsRunning = true;
-    auto watcher = qobject_cast<QDBusServiceWatcher*>(sender());
-    if (!watcher) {
-        packagekitIsRunning = nameHasOwner(QLatin1String("org.freedesktop.PackageKit"),
-                                           QDBusConnection::systemBus());
+    if (qobject_cast<QDBusServiceWatcher*>(sender())) {
+        applyProxy();
+        return;
     }
 
-    if (packagekitIsRunning) {
+    auto call = nameHasOwner(QLatin1String("org.freedesktop.PackageKit"),
+                             QDBusConnection::systemBus(),
+                             this);
+    connect(call, &QDBusPendingCallWatcher::finished, this, [this] (QDBusPendingCallWatcher *call) {
+        QDBusPendingReply<bool> reply = *call;
         // Apply the proxy changes only if packagekit is running
-        // use value() to not insert items on the hash
-        Daemon::global()->setProxy(m_proxyConfig.value(QLatin1String("http")),
-                                   m_proxyConfig.value(QLatin1String("https")),
-                                   m_proxyConfig.value(QLatin1String("ftp")),
-                                   m_proxyConfig.value(QLatin1String("socks")),
-                                   QString(),
-                                   QString());
-        m_proxyChanged = false;
+        if (reply.isValid() && reply.value()) {
+            applyProxy();
+        }
+        call->deleteLater();
+    });
+}
+
+void ApperdThread::applyProxy()
+{
+    if (!m_proxyChanged) {
+        return;
     }
+
+    // use value() to not insert items on the hash
+    Daemon::global()->setProxy(m_proxyConfig.value(QLatin1String("http")),
+                               m_proxyConfig.value(QLatin1String("https")),
+                               m_proxyConfig.value(QLatin1String("ftp")),
+                               m_proxyConfig.value(QLatin1String("socks")),
+                               QString(),
+                               QString());
+    m_proxyChanged = false;
 }
 
 void ApperdThread::updatesChanged()
 {
-    // update the last time the cache was refreshed
-    QDateTime lastCacheRefresh;
-    lastCacheRefresh = getTimeSinceRefreshCache();
-    if (lastCacheRefresh != m_lastRefreshCache) {
-        m_lastRefreshCache = lastCacheRefresh;
-    }
+    // the cache might have been refreshed, count the interval from it
+    scheduleRefreshCache();
 
     bool ignoreBattery = m_configs[QLatin1String(CFG_INSTALL_UP_BATTERY)].value<bool>();
     bool ignoreMobile = m_configs[QLatin1String(CFG_INSTALL_UP_MOBILE)].value<bool>();
 
     // Make sure the user sees the updates
     m_updater->checkForUpdates(isSystemReady(ignoreBattery, ignoreMobile));
-    m_distroUpgrade->checkDistroUpgrades();
+
+    if (m_scheduler->deadline(Scheduler::TaskDistroUpgrade).isNull()) {
+        // The first time we get here, later ones are scheduled
+        m_scheduler->schedule(Scheduler::TaskDistroUpgrade, QDateTime::currentDateTime());
+    }
+}
+
+void ApperdThread::updatesListed(const UpdateItemList &updates, uint generation)
+{
+    QSet<QString> securityUpdates;
+    for (const UpdateItem &item : updates) {
+        if (item.info == Transaction::InfoSecurity) {
+            securityUpdates << item.packageID;
+        }
+    }
+
+    // Before the first list there is nothing to compare with
+    if (m_refreshOutcomePending && m_generation != 0) {
+        const bool changed = generation != m_generation;
+        const bool security = !(securityUpdates - m_securityUpdates).isEmpty();
+        m_refreshPolicy.recordRefresh(changed, security);
+        m_refreshCache->setCacheAge(m_refreshPolicy.cacheAge());
+        qCDebug(APPER_DAEMON) << "Refresh found changes" << changed << "security" << security
+                              << "next interval" << m_refreshPolicy.interval();
+
+        // Use the new interval
+        scheduleRefreshCache();
+    }
+    m_refreshOutcomePending = false;
+    m_generation = generation;
+    m_securityUpdates = securityUpdates;
 }
 
 void ApperdThread::appShouldConserveResourcesChanged()
@@ -275,21 +412,7 @@ void ApperdThread::appShouldConserveResourcesChanged()
     }
 }
 
-QDateTime ApperdThread::getTimeSinceRefreshCache() const
-{
-    uint value = Daemon::global()->getTimeSinceAction(Transaction::RoleRefreshCache);
-
-    // When the refresh cache value was not yet defined UINT_MAX is returned
-    if (value == UINT_MAX) {
-        return QDateTime();
-    } else {
-        // Calculate the last time the cache was refreshed by
-        // subtracting the seconds from the current time
-        return QDateTime::currentDateTime().addSecs(value * -1);
-    }
-}
-
-bool ApperdThread::nameHasOwner(const QString &name, const QDBusConnection &connection)
+QDBusPendingCallWatcher *ApperdThread::nameHasOwner(const QString &name, const QDBusConnection &connection, QObject *parent)
 {
     QDBusMessage message;
     message = QDBusMessage::createMethodCall(QLatin1String("org.freedesktop.DBus"),
@@ -297,19 +420,19 @@ bool ApperdThread::nameHasOwner(const QString &name, const QDBusConnection &conn
                                              QLatin1String("org.freedesktop.DBus"),
                                              QLatin1String("NameHasOwner"));
     message << qVariantFromValue(name);
-    QDBusReply<bool> reply = connection.call(message);
-    return reply.value();
+    return new QDBusPendingCallWatcher(connection.asyncCall(message), parent);
 }
 
 bool ApperdThread::isSystemReady(bool ignoreBattery, bool ignoreMobile) const
 {
     // First check if we should conserve resources
-    // check how applications should behave (e.g. on battery power)
-//    if (!ignoreBattery && Solid::PowerManagement::appShouldConserveResources()) {
+    // check how applications should behave (e.g. on battery power),
+    // without power management the state is unknown and rather than
+    // never updating on such sessions we go ahead like on AC power
+    if (!ignoreBattery && m_hasPowerManagement && Solid::PowerManagement::appShouldConserveResources()) {
         qCDebug(APPER_DAEMON) << "System is not ready, application should conserve resources";
-        // This was fixed for KDElibs 4.8.5
         return false;
-//    }
+    }
 
     // TODO it would be nice is Solid provided this
     // so we wouldn't be waking up PackageKit for this Solid task.
@@ -22,7 +22,14 @@
 
 #include <QTimer>
 #include <QDBusConnection>
+#include <QDBusPendingCallWatcher>
 #include <QDateTime>
+#include <QSet>
+
+#include "RefreshPolicy.h"
+#include "Scheduler.h"
+
+#include <UpdateItem.h>
 
 class DBusInterface;
 class DistroUpgrade;
@@ -38,27 +45,39 @@ public:
     explicit ApperdThread(QObject *parent = nullptr);
     ~ApperdThread() override;
 
-    static bool nameHasOwner(const QString &name, const QDBusConnection &connection);
+    /**
+     * Asks the bus if name is owned without waiting for the answer,
+     * the returned watcher has a QDBusPendingReply<bool>
+     */
+    static QDBusPendingCallWatcher *nameHasOwner(const QString &name, const QDBusConnection &connection, QObject *parent);
 
 private Q_SLOTS:
     void init();
-    void poll();
+    void taskDue(Scheduler::Task task);
     void configFileChanged();
     void proxyChanged();
     void setProxy();
 
     void updatesChanged();
+    void updatesListed(const UpdateItemList &updates, uint generation);
     void appShouldConserveResourcesChanged();
 
 private:
-    QDateTime getTimeSinceRefreshCache() const;
+    void scheduleRefreshCache();
+    void applyProxy();
     bool isSystemReady(bool ignoreBattery, bool ignoreMobile) const;
 
     bool m_proxyChanged;
+    // Whether anything provides the power state Solid reports
+    bool m_hasPowerManagement = false;
     QVariantHash m_configs;
     QHash<QString, QString> m_proxyConfig;
     QDateTime m_lastRefreshCache;
-    QTimer *m_qtimer;
+    RefreshPolicy m_refreshPolicy;
+    bool m_refreshOutcomePending = false;
+    uint m_generation = 0;
+    QSet<QString> m_securityUpdates;
+    Scheduler *m_scheduler;
 
     DBusInterface *m_interface;
     DistroUpgrade *m_distroUpgrade;
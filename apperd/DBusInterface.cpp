@@ -21,16 +21,21 @@
 #include "DBusInterface.h"
 
 #include "apperdadaptor.h"
+#include "RefreshPolicy.h"
+#include "TransactionStats.h"
+#include "Watchdog.h"
 
 #include <QtDBus/QDBusConnection>
 
+#include <Transaction>
+
 #ifdef HAVE_DEBCONFKDE
 #include <KDialog>
 #include <KWindowSystem>
-#include <Transaction>
-using namespace PackageKit;
 #endif
 
+using namespace PackageKit;
+
 #include <QLoggingCategory>
 
 Q_DECLARE_LOGGING_CATEGORY(APPER_DAEMON)
@@ -39,6 +44,7 @@ DBusInterface::DBusInterface(QObject *parent) :
     QObject(parent)
 {
     qCDebug(APPER_DAEMON) << "Creating Helper";
+    registerUpdateItemTypes();
     (void) new ApperdAdaptor(this);
     if (!QDBusConnection::sessionBus().registerService(QStringLiteral("org.kde.apperd"))) {
         qCDebug(APPER_DAEMON) << "another helper is already running";
@@ -61,6 +67,11 @@ void DBusInterface::RefreshCache()
     emit refreshCache();
 }
 
+void DBusInterface::PrepareOfflineUpdate()
+{
+    emit prepareOfflineUpdate();
+}
+
 void DBusInterface::SetupDebconfDialog(const QString &tid, const QString &socketPath, uint xidParent)
 {
 #ifdef HAVE_DEBCONFKDE
@@ -97,6 +108,110 @@ void DBusInterface::WatchTransaction(const QDBusObjectPath &tid)
     emit watchTransaction(tid);
 }
 
+UpdateItemList DBusInterface::GetUpdates(uint &generation) const
+{
+    // Lets the caller match the list with UpdatesChanged()
+    generation = m_generation;
+    if (m_generation == 0 && calledFromDBus()) {
+        // An empty list would read as "no updates",
+        // let the caller ask PackageKit instead
+        sendErrorReply(QDBusError::Failed, QLatin1String("The update list is not known yet"));
+    }
+    return m_updates;
+}
+
+QVariantMap DBusInterface::GetUpdateSummary() const
+{
+    uint total = 0;
+    uint security = 0;
+    uint important = 0;
+    uint blocked = 0;
+    for (const UpdateItem &item : m_updates) {
+        switch (item.info) {
+        case Transaction::InfoBlocked:
+            // Blocked updates can't be installed, so they don't count
+            ++blocked;
+            continue;
+        case Transaction::InfoSecurity:
+            ++security;
+            break;
+        case Transaction::InfoImportant:
+            ++important;
+            break;
+        default:
+            break;
+        }
+        ++total;
+    }
+
+    QVariantMap ret;
+    ret[QLatin1String("generation")] = m_generation;
+    // Equal fingerprints mean the same set of updates, in any order
+    ret[QLatin1String("fingerprint")] = m_fingerprint;
+    ret[QLatin1String("total")] = total;
+    ret[QLatin1String("security")] = security;
+    ret[QLatin1String("important")] = important;
+    ret[QLatin1String("blocked")] = blocked;
+    // 0 while apperd has not listed the updates yet
+    ret[QLatin1String("lastCheck")] = m_lastCheck.isValid() ? m_lastCheck.toMSecsSinceEpoch() / 1000 : Q_INT64_C(0);
+    return ret;
+}
+
+QVariantMap DBusInterface::GetWatchdogStats() const
+{
+    QVariantMap ret;
+    if (m_watchdog) {
+        // How long kded's main thread was unresponsive, in milliseconds
+        ret[QLatin1String("longestStall")] = m_watchdog->longestStall();
+        ret[QLatin1String("lastStall")] = m_watchdog->lastStall();
+    }
+    return ret;
+}
+
+QVariantMap DBusInterface::GetRefreshStats() const
+{
+    if (m_refreshPolicy) {
+        // The learned interval, its bounds and the last refreshes
+        return m_refreshPolicy->stats();
+    }
+    return QVariantMap();
+}
+
+QVariantMap DBusInterface::Stats() const
+{
+    if (m_transactionStats) {
+        // Per role histograms of the last transactions
+        return m_transactionStats->stats();
+    }
+    return QVariantMap();
+}
+
+void DBusInterface::setWatchdog(Watchdog *watchdog)
+{
+    m_watchdog = watchdog;
+}
+
+void DBusInterface::setRefreshPolicy(const RefreshPolicy *policy)
+{
+    m_refreshPolicy = policy;
+}
+
+void DBusInterface::setTransactionStats(const TransactionStats *stats)
+{
+    m_transactionStats = stats;
+}
+
+void DBusInterface::setUpdates(const UpdateItemList &updates, uint generation, const QString &fingerprint)
+{
+    m_updates = updates;
+    m_fingerprint = fingerprint;
+    m_lastCheck = QDateTime::currentDateTime();
+    if (m_generation != generation) {
+        m_generation = generation;
+        emit UpdatesChanged(generation);
+    }
+}
+
 void DBusInterface::debconfActivate()
 {
 #ifdef HAVE_DEBCONFKDE
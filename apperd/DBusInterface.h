@@ -22,6 +22,10 @@
 
 #include <QtDBus/QDBusContext>
 #include <QDBusObjectPath>
+#include <QDateTime>
+#include <QVariantMap>
+
+#include <UpdateItem.h>
 
 #include <config.h>
 
@@ -30,6 +34,9 @@
 using namespace DebconfKde;
 #endif //HAVE_DEBCONFKDE
 
+class RefreshPolicy;
+class TransactionStats;
+class Watchdog;
 class DBusInterface : public QObject, protected QDBusContext
 {
     Q_OBJECT
@@ -39,19 +46,45 @@ public:
     ~DBusInterface() override;
 
     void RefreshCache();
+    void PrepareOfflineUpdate();
     void SetupDebconfDialog(const QString &tid, const QString &socketPath, uint xidParent);
     void WatchTransaction(const QDBusObjectPath &tid);
+    UpdateItemList GetUpdates(uint &generation) const;
+    QVariantMap GetUpdateSummary() const;
+    QVariantMap GetWatchdogStats() const;
+    QVariantMap GetRefreshStats() const;
+    QVariantMap Stats() const;
+
+    void setWatchdog(Watchdog *watchdog);
+    void setRefreshPolicy(const RefreshPolicy *policy);
+    void setTransactionStats(const TransactionStats *stats);
+
+public Q_SLOTS:
+    /**
+     * Publishes the update list apperd got from PackageKit,
+     * clients are told with UpdatesChanged()
+     */
+    void setUpdates(const UpdateItemList &updates, uint generation, const QString &fingerprint);
 
 Q_SIGNALS:
     void refreshCache();
+    void prepareOfflineUpdate();
     void watchTransaction(const QDBusObjectPath &tid);
+    void UpdatesChanged(uint generation);
 
 private Q_SLOTS:
     void debconfActivate();
     void transactionFinished();
 
-#ifdef HAVE_DEBCONFKDE
 private:
+    UpdateItemList m_updates;
+    uint m_generation = 0;
+    QString m_fingerprint;
+    QDateTime m_lastCheck;
+    Watchdog *m_watchdog = nullptr;
+    const RefreshPolicy *m_refreshPolicy = nullptr;
+    const TransactionStats *m_transactionStats = nullptr;
+#ifdef HAVE_DEBCONFKDE
     QHash<QString, DebconfGui*> m_debconfGuis;
 #endif
 };
@@ -0,0 +1,101 @@
+/***************************************************************************
+ *   Copyright (C) 2026 by agent                                           *
+ *   agent@local                                                           *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; see the file COPYING. If not, write to       *
+ *   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,  *
+ *   Boston, MA 02110-1301, USA.                                           *
+ ***************************************************************************/
+
+#include "OfflineUpdateTask.h"
+
+#include <PkIcons.h>
+
+#include <Daemon>
+#include <Offline>
+
+#include <KLocalizedString>
+#include <KNotification>
+
+#include <QDBusPendingCallWatcher>
+#include <QDBusPendingReply>
+
+#include <QLoggingCategory>
+
+Q_DECLARE_LOGGING_CATEGORY(APPER_DAEMON)
+
+OfflineUpdateTask::OfflineUpdateTask(QObject *parent) :
+    QObject(parent),
+    m_transaction(nullptr),
+    m_count(0)
+{
+}
+
+bool OfflineUpdateTask::isPreparing() const
+{
+    return m_transaction;
+}
+
+void OfflineUpdateTask::prepare(const QStringList &packageIDs)
+{
+    if (m_transaction || packageIDs.isEmpty()) {
+        return;
+    }
+
+    // A download only update makes PackageKit write the
+    // prepared update that is installed offline
+    m_count = packageIDs.size();
+    m_transaction = Daemon::updatePackages(packageIDs,
+                                           Transaction::TransactionFlagOnlyTrusted |
+                                           Transaction::TransactionFlagOnlyDownload);
+    m_transaction->setHints(QLatin1String("background=true"));
+    connect(m_transaction, &Transaction::finished, this, &OfflineUpdateTask::prepareFinished);
+}
+
+void OfflineUpdateTask::prepareFinished(Transaction::Exit status)
+{
+    m_transaction = nullptr;
+    if (status != Transaction::ExitSuccess) {
+        qCWarning(APPER_DAEMON) << "Failed to prepare the offline update" << status;
+        emit failed();
+        return;
+    }
+    emit prepared();
+
+    auto notify = new KNotification(QLatin1String("OfflineUpdatePrepared"), nullptr, KNotification::Persistent);
+    notify->setComponentName(QLatin1String("apperd"));
+    connect(notify, &KNotification::action1Activated, this, &OfflineUpdateTask::installOnReboot);
+    connect(notify, &KNotification::action2Activated, this, &OfflineUpdateTask::reviewUpdates);
+    notify->setTitle(i18np("One update is ready to be installed",
+                           "%1 updates are ready to be installed",
+                           m_count));
+    notify->setText(i18n("The updates were downloaded and can be installed while the computer restarts."));
+    notify->setActions({i18n("Install on Next Reboot"), i18n("Review")});
+    // use of QSize does the right thing
+    notify->setPixmap(QIcon::fromTheme(QLatin1String("system-software-update")).pixmap(KPK_ICON_SIZE, KPK_ICON_SIZE));
+    notify->sendEvent();
+}
+
+void OfflineUpdateTask::installOnReboot()
+{
+    auto call = new QDBusPendingCallWatcher(Daemon::global()->offline()->trigger(Offline::ActionReboot), this);
+    connect(call, &QDBusPendingCallWatcher::finished, this, [] (QDBusPendingCallWatcher *call) {
+        call->deleteLater();
+        if (call->isError()) {
+            qCWarning(APPER_DAEMON) << "Failed to trigger the offline update" << call->error().message();
+        }
+    });
+}
+
+#include "moc_OfflineUpdateTask.cpp"
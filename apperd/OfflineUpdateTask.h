@@ -0,0 +1,58 @@
+/***************************************************************************
+ *   Copyright (C) 2026 by agent                                           *
+ *   agent@local                                                           *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; see the file COPYING. If not, write to       *
+ *   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,  *
+ *   Boston, MA 02110-1301, USA.                                           *
+ ***************************************************************************/
+
+#ifndef OFFLINEUPDATETASK_H
+#define OFFLINEUPDATETASK_H
+
+#include <Transaction>
+
+using namespace PackageKit;
+
+/**
+ * Downloads updates and has PackageKit stage them, so they can
+ * be installed on the next reboot instead of while applications
+ * are still running against the old libraries
+ */
+class OfflineUpdateTask : public QObject
+{
+    Q_OBJECT
+public:
+    explicit OfflineUpdateTask(QObject *parent = nullptr);
+
+    bool isPreparing() const;
+
+public Q_SLOTS:
+    void prepare(const QStringList &packageIDs);
+
+Q_SIGNALS:
+    void prepared();
+    void failed();
+    void reviewUpdates();
+
+private Q_SLOTS:
+    void prepareFinished(PackageKit::Transaction::Exit status);
+    void installOnReboot();
+
+private:
+    Transaction *m_transaction;
+    int m_count;
+};
+
+#endif // OFFLINEUPDATETASK_H
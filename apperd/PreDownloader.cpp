@@ -0,0 +1,237 @@
+/***************************************************************************
+ *   Copyright (C) 2026 by agent                                           *
+ *   agent@local                                                           *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; see the file COPYING. If not, write to       *
+ *   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,  *
+ *   Boston, MA 02110-1301, USA.                                           *
+ ***************************************************************************/
+
+#include "PreDownloader.h"
+
+#include "PressureMonitor.h"
+
+#include <Daemon>
+
+#include <Enum.h>
+
+#include <KConfig>
+#include <KConfigGroup>
+
+#include <QStandardPaths>
+#include <QTimer>
+
+#include <algorithm>
+#include <limits.h>
+
+#include <QLoggingCategory>
+
+Q_DECLARE_LOGGING_CATEGORY(APPER_DAEMON)
+
+#define STATE_FILE     "apperdstaterc"
+#define BATCH_SIZE     5
+// Seconds to wait after a batch failed
+#define RETRY_DELAY    (30 * 60)
+// Attempts of a batch before giving up
+#define MAX_RETRIES    3
+
+using namespace PackageKit;
+
+PreDownloader::PreDownloader(QObject *parent) :
+    QObject(parent),
+    m_budget(DEFAULT_DOWNLOAD_BUDGET),
+    m_pressure(new PressureMonitor(this)),
+    m_timer(new QTimer(this))
+{
+    m_timer->setSingleShot(true);
+    m_timer->setTimerType(Qt::VeryCoarseTimer);
+    connect(m_timer, &QTimer::timeout, this, &PreDownloader::next);
+    connect(m_pressure, &PressureMonitor::calm, this, &PreDownloader::next);
+
+    KConfig state(QLatin1String(STATE_FILE), KConfig::SimpleConfig, QStandardPaths::GenericDataLocation);
+    KConfigGroup preDownloadGroup(&state, "PreDownload");
+    m_downloaded = preDownloadGroup.readEntry("Downloaded", QStringList()).toSet();
+}
+
+PreDownloader::~PreDownloader()
+{
+}
+
+void PreDownloader::setConfig(const QVariantHash &configs)
+{
+    m_budget = configs[QLatin1String(CFG_DOWNLOAD_BUDGET)].toUInt();
+    m_pressure->setMaxPressure(configs[QLatin1String(CFG_MAX_PRESSURE)].toDouble());
+    m_pressure->setMaxLoad(configs[QLatin1String(CFG_MAX_LOAD)].toDouble());
+    m_pressure->setCalmPeriod(configs[QLatin1String(CFG_CALM_PERIOD)].toInt());
+}
+
+void PreDownloader::setEnabled(bool enabled)
+{
+    m_enabled = enabled;
+    if (!m_enabled) {
+        // The running batch is left to finish
+        m_timer->stop();
+    } else if (!m_timer->isActive()) {
+        m_timer->start(0);
+    }
+}
+
+void PreDownloader::setUpdates(const UpdateItemList &updates)
+{
+    QVector<QPair<int, QString> > ranked;
+    QSet<QString> current;
+    for (const UpdateItem &item : updates) {
+        if (item.info == Transaction::InfoBlocked) {
+            continue;
+        }
+        current << item.packageID;
+        if (!m_downloaded.contains(item.packageID)) {
+            ranked << qMakePair(rank(item.info), item.packageID);
+        }
+    }
+    // stable, so PackageKit's order is kept within a rank
+    std::stable_sort(ranked.begin(), ranked.end(), [] (const QPair<int, QString> &a, const QPair<int, QString> &b) {
+        return a.first < b.first;
+    });
+
+    QStringList queue;
+    for (const auto &pair : qAsConst(ranked)) {
+        queue << pair.second;
+    }
+    if (queue != m_queue) {
+        // Different updates, they might download fine
+        m_queue = queue;
+        m_retries = 0;
+        m_gaveUp = false;
+    }
+
+    // Forget what was already installed or superseded
+    if (!(m_downloaded - current).isEmpty()) {
+        m_downloaded &= current;
+        save();
+    }
+
+    // An empty queue still reports it is done
+    if (m_enabled && !m_timer->isActive()) {
+        m_timer->start(0);
+    }
+}
+
+bool PreDownloader::isDownloading() const
+{
+    return m_transaction;
+}
+
+void PreDownloader::next()
+{
+    if (!m_enabled || m_transaction || m_gaveUp) {
+        return;
+    }
+
+    if (m_queue.isEmpty()) {
+        emit finished();
+        return;
+    }
+
+    if (!m_pressure->isCalm()) {
+        // next() is called again once it is
+        m_pressure->waitForCalm();
+        return;
+    }
+
+    m_batch = m_queue.mid(0, BATCH_SIZE);
+    m_batchBytes = 0;
+    m_batchTime.start();
+    qCDebug(APPER_DAEMON) << "Pre-downloading" << m_batch << m_queue.size() << "left";
+
+    m_transaction = Daemon::updatePackages(m_batch,
+                                           Transaction::TransactionFlagOnlyTrusted |
+                                           Transaction::TransactionFlagOnlyDownload);
+    m_transaction->setHints(QLatin1String("background=true"));
+    connect(m_transaction, &Transaction::downloadSizeRemainingChanged, this, &PreDownloader::downloadSizeRemainingChanged);
+    connect(m_transaction, &Transaction::finished, this, &PreDownloader::batchFinished);
+}
+
+void PreDownloader::batchFinished(Transaction::Exit status)
+{
+    m_transaction = nullptr;
+
+    if (status != Transaction::ExitSuccess) {
+        qCDebug(APPER_DAEMON) << "Pre-download failed" << status;
+        if (++m_retries >= MAX_RETRIES) {
+            qCWarning(APPER_DAEMON) << "Giving up pre-downloading" << m_batch;
+            m_gaveUp = true;
+            emit failed();
+        } else if (m_enabled) {
+            m_timer->start(RETRY_DELAY * 1000);
+        }
+        return;
+    }
+    m_retries = 0;
+
+    for (const QString &packageID : qAsConst(m_batch)) {
+        m_downloaded << packageID;
+        m_queue.removeOne(packageID);
+    }
+    m_batch.clear();
+    save();
+
+    if (m_queue.isEmpty()) {
+        emit finished();
+        return;
+    }
+
+    qint64 pause = 0;
+    if (m_budget) {
+        // Time the batch should have taken at the
+        // budget, minus the time it did take
+        pause = qint64(m_batchBytes * 1000 / (qulonglong(m_budget) * 1024)) - m_batchTime.elapsed();
+    }
+    if (m_enabled) {
+        m_timer->start(int(qBound<qint64>(0, pause, INT_MAX)));
+    }
+}
+
+void PreDownloader::downloadSizeRemainingChanged()
+{
+    if (!m_transaction) {
+        return;
+    }
+
+    // The largest value seen is what the batch downloads
+    m_batchBytes = qMax(m_batchBytes, m_transaction->downloadSizeRemaining());
+}
+
+int PreDownloader::rank(uint info)
+{
+    switch (info) {
+    case Transaction::InfoSecurity:
+        return 0;
+    case Transaction::InfoImportant:
+        return 1;
+    case Transaction::InfoLow:
+        return 3;
+    default:
+        return 2;
+    }
+}
+
+void PreDownloader::save() const
+{
+    KConfig state(QLatin1String(STATE_FILE), KConfig::SimpleConfig, QStandardPaths::GenericDataLocation);
+    KConfigGroup preDownloadGroup(&state, "PreDownload");
+    preDownloadGroup.writeEntry("Downloaded", m_downloaded.toList());
+}
+
+#include "moc_PreDownloader.cpp"
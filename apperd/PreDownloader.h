@@ -0,0 +1,96 @@
+/***************************************************************************
+ *   Copyright (C) 2026 by agent                                           *
+ *   agent@local                                                           *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; see the file COPYING. If not, write to       *
+ *   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,  *
+ *   Boston, MA 02110-1301, USA.                                           *
+ ***************************************************************************/
+
+#ifndef PREDOWNLOADER_H
+#define PREDOWNLOADER_H
+
+#include <Transaction>
+
+#include <UpdateItem.h>
+
+#include <QElapsedTimer>
+#include <QSet>
+#include <QStringList>
+
+class QTimer;
+class PressureMonitor;
+
+/**
+ * Downloads the updates ahead of time, so installing them
+ * doesn't have to wait for the network.
+ *
+ * Security updates go first, then the important ones. They are
+ * fetched a few at a time while the system is calm, pausing between
+ * batches to keep the average rate under the bandwidth budget. What
+ * was downloaded is remembered, so a restart carries on from there.
+ * A batch that keeps failing stops the downloads until the list of
+ * updates changes.
+ */
+class PreDownloader : public QObject
+{
+    Q_OBJECT
+public:
+    explicit PreDownloader(QObject *parent = nullptr);
+    ~PreDownloader() override;
+
+    void setConfig(const QVariantHash &configs);
+    void setEnabled(bool enabled);
+    void setUpdates(const UpdateItemList &updates);
+
+    bool isDownloading() const;
+
+Q_SIGNALS:
+    /**
+     * All updates were downloaded, also emitted when
+     * there was nothing left to download
+     */
+    void finished();
+    /**
+     * A batch failed too many times, the
+     * remaining updates are not downloaded
+     */
+    void failed();
+
+private Q_SLOTS:
+    void next();
+    void batchFinished(PackageKit::Transaction::Exit status);
+    void downloadSizeRemainingChanged();
+
+private:
+    static int rank(uint info);
+    void save() const;
+
+    bool m_enabled = false;
+    // KiB/s, 0 means no limit
+    uint m_budget;
+    QStringList m_queue;
+    QSet<QString> m_downloaded;
+    QStringList m_batch;
+    // Failures of the current batch in a row
+    int m_retries = 0;
+    bool m_gaveUp = false;
+    qulonglong m_batchBytes = 0;
+    QElapsedTimer m_batchTime;
+    PackageKit::Transaction *m_transaction = nullptr;
+    PressureMonitor *m_pressure;
+    QTimer *m_timer;
+};
+
+#endif // PREDOWNLOADER_H
@@ -0,0 +1,156 @@
+/***************************************************************************
+ *   Copyright (C) 2026 by agent                                           *
+ *   agent@local                                                           *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; see the file COPYING. If not, write to       *
+ *   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,  *
+ *   Boston, MA 02110-1301, USA.                                           *
+ ***************************************************************************/
+
+#include "PressureMonitor.h"
+
+#include <QFile>
+#include <QStringList>
+#include <QThread>
+#include <QTimer>
+
+#include <QLoggingCategory>
+
+#include <Enum.h>
+
+#define SAMPLE_INTERVAL 60
+
+Q_DECLARE_LOGGING_CATEGORY(APPER_DAEMON)
+
+PressureMonitor::PressureMonitor(QObject *parent) :
+    QObject(parent),
+    m_maxPressure(DEFAULT_MAX_PRESSURE),
+    m_maxLoad(DEFAULT_MAX_LOAD),
+    m_calmPeriod(DEFAULT_CALM_PERIOD),
+    m_timer(new QTimer(this))
+{
+    m_timer->setInterval(SAMPLE_INTERVAL * 1000);
+    m_timer->setTimerType(Qt::VeryCoarseTimer);
+    connect(m_timer, &QTimer::timeout, this, &PressureMonitor::sample);
+}
+
+PressureMonitor::~PressureMonitor()
+{
+}
+
+void PressureMonitor::setMaxPressure(double percent)
+{
+    m_maxPressure = percent;
+}
+
+void PressureMonitor::setMaxLoad(double loadPerCpu)
+{
+    m_maxLoad = loadPerCpu;
+}
+
+void PressureMonitor::setCalmPeriod(int seconds)
+{
+    m_calmPeriod = qMax(0, seconds);
+}
+
+bool PressureMonitor::isCalm() const
+{
+    if (m_maxPressure >= 0) {
+        const QStringList resources = {
+            QLatin1String("cpu"),
+            QLatin1String("io"),
+            QLatin1String("memory")
+        };
+        for (const QString &resource : resources) {
+            const double value = pressure(resource);
+            if (value > m_maxPressure) {
+                qCDebug(APPER_DAEMON) << "System is busy," << resource << "pressure" << value;
+                return false;
+            }
+        }
+    }
+
+    if (m_maxLoad >= 0) {
+        const double load = loadPerCpu();
+        if (load > m_maxLoad) {
+            qCDebug(APPER_DAEMON) << "System is busy, load per CPU" << load;
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool PressureMonitor::isWaiting() const
+{
+    return m_timer->isActive();
+}
+
+void PressureMonitor::waitForCalm()
+{
+    if (m_timer->isActive()) {
+        return;
+    }
+
+    m_calmFor = 0;
+    m_timer->start();
+}
+
+void PressureMonitor::sample()
+{
+    if (!isCalm()) {
+        m_calmFor = 0;
+        return;
+    }
+
+    m_calmFor += SAMPLE_INTERVAL;
+    if (m_calmFor >= m_calmPeriod) {
+        m_timer->stop();
+        emit calm();
+    }
+}
+
+double PressureMonitor::pressure(const QString &resource)
+{
+    // some avg10=0.00 avg60=0.00 avg300=0.00 total=0
+    QFile file(QLatin1String("/proc/pressure/") + resource);
+    if (!file.open(QIODevice::ReadOnly)) {
+        // Kernels without PSI, the load average still applies
+        return 0;
+    }
+
+    const QList<QByteArray> fields = file.readLine().simplified().split(' ');
+    double ret = 0;
+    for (const QByteArray &field : fields) {
+        // avg10 reacts to what just started, avg60 to what
+        // has been going on, the system must be calm on both
+        if (field.startsWith("avg10=") || field.startsWith("avg60=")) {
+            ret = qMax(ret, field.mid(field.indexOf('=') + 1).toDouble());
+        }
+    }
+    return ret;
+}
+
+double PressureMonitor::loadPerCpu()
+{
+    QFile file(QLatin1String("/proc/loadavg"));
+    if (!file.open(QIODevice::ReadOnly)) {
+        return 0;
+    }
+
+    const double load = file.readLine().split(' ').value(0).toDouble();
+    return load / qMax(1, QThread::idealThreadCount());
+}
+
+#include "moc_PressureMonitor.cpp"
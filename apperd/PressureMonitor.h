@@ -0,0 +1,81 @@
+/***************************************************************************
+ *   Copyright (C) 2026 by agent                                           *
+ *   agent@local                                                           *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; see the file COPYING. If not, write to       *
+ *   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,  *
+ *   Boston, MA 02110-1301, USA.                                           *
+ ***************************************************************************/
+
+#ifndef PRESSUREMONITOR_H
+#define PRESSUREMONITOR_H
+
+#include <QObject>
+
+class QTimer;
+
+/**
+ * Tells when the machine is busy, so automatic updates
+ * don't compete with what the user is doing.
+ *
+ * Uses the kernel's pressure stall information from /proc/pressure
+ * when available and the load average per CPU. waitForCalm() samples
+ * them until they stayed below the thresholds for the calm period.
+ */
+class PressureMonitor : public QObject
+{
+    Q_OBJECT
+public:
+    explicit PressureMonitor(QObject *parent = nullptr);
+    ~PressureMonitor() override;
+
+    /**
+     * Percentage of time tasks stalled on CPU, IO or memory above
+     * which the system is busy, negative disables the check
+     */
+    void setMaxPressure(double percent);
+    /**
+     * One minute load average per CPU above which the
+     * system is busy, negative disables the check
+     */
+    void setMaxLoad(double loadPerCpu);
+    void setCalmPeriod(int seconds);
+
+    bool isCalm() const;
+    bool isWaiting() const;
+
+public Q_SLOTS:
+    /**
+     * Emits calm() once the system was calm for the calm period
+     */
+    void waitForCalm();
+
+Q_SIGNALS:
+    void calm();
+
+private Q_SLOTS:
+    void sample();
+
+private:
+    static double pressure(const QString &resource);
+    static double loadPerCpu();
+
+    double m_maxPressure;
+    double m_maxLoad;
+    int m_calmPeriod;
+    int m_calmFor = 0;
+    QTimer *m_timer;
+};
+
+#endif // PRESSUREMONITOR_H
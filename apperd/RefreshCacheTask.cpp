@@ -37,6 +37,11 @@ RefreshCacheTask::RefreshCacheTask(QObject *parent) :
 {
 }
 
+void RefreshCacheTask::setCacheAge(uint seconds)
+{
+    m_cacheAge = seconds;
+}
+
 void RefreshCacheTask::refreshCache()
 {
 //    kDebug();
@@ -58,6 +63,7 @@ void RefreshCacheTask::refreshCacheFinished(PackageKit::Transaction::Exit status
     if (status == Transaction::ExitSuccess) {
         m_lastError = Transaction::ErrorUnknown;
         m_lastErrorString.clear();
+        emit refreshed();
     }
 }
 
@@ -32,9 +32,17 @@ class RefreshCacheTask : public QObject
 public:
     explicit RefreshCacheTask(QObject *parent = nullptr);
 
+    /**
+     * Metadata younger than seconds is not downloaded again
+     */
+    void setCacheAge(uint seconds);
+
 public Q_SLOTS:
     void refreshCache();
 
+Q_SIGNALS:
+    void refreshed();
+
 private Q_SLOTS:
     void refreshCacheFinished(PackageKit::Transaction::Exit status, uint runtime);
     void errorCode(PackageKit::Transaction::Error error, const QString &errorMessage);
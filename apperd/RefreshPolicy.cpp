@@ -0,0 +1,152 @@
+/***************************************************************************
+ *   Copyright (C) 2026 by agent                                           *
+ *   agent@local                                                           *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; see the file COPYING. If not, write to       *
+ *   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,  *
+ *   Boston, MA 02110-1301, USA.                                           *
+ ***************************************************************************/
+
+#include "RefreshPolicy.h"
+
+#include <Enum.h>
+
+#include <KConfig>
+#include <KConfigGroup>
+
+#include <QStandardPaths>
+#include <QStringList>
+
+#define STATE_FILE   "apperdstaterc"
+// How many refreshes are kept to be shown over D-Bus
+#define HISTORY_SIZE 16
+
+RefreshPolicy::RefreshPolicy()
+{
+    load();
+}
+
+void RefreshPolicy::setBounds(uint interval, uint minInterval, uint maxInterval)
+{
+    m_minInterval = minInterval ? minInterval : qMax<uint>(interval / 4, Enum::Hourly);
+    m_maxInterval = maxInterval ? maxInterval : qMin<uint>(interval * 4, Enum::Monthly);
+    m_maxInterval = qMax(m_minInterval, m_maxInterval);
+
+    // Nothing learned yet or the user changed their mind,
+    // start from what they asked for
+    if (m_interval == 0 || interval != m_userInterval) {
+        m_userInterval = interval;
+        m_interval = interval;
+    }
+    m_interval = qBound(m_minInterval, m_interval, m_maxInterval);
+}
+
+void RefreshPolicy::recordRefresh(bool changed, bool security)
+{
+    if (security) {
+        // Keep up with security fixes while they are coming
+        m_interval = m_minInterval;
+    } else if (changed) {
+        m_interval /= 2;
+    } else {
+        m_interval += m_interval / 2;
+    }
+    m_interval = qBound(m_minInterval, m_interval, m_maxInterval);
+
+    Record record;
+    record.time = QDateTime::currentDateTime();
+    record.changed = changed;
+    record.security = security;
+    record.interval = m_interval;
+    m_history << record;
+    if (m_history.size() > HISTORY_SIZE) {
+        m_history.remove(0, m_history.size() - HISTORY_SIZE);
+    }
+
+    save();
+}
+
+uint RefreshPolicy::interval() const
+{
+    return m_interval;
+}
+
+uint RefreshPolicy::cacheAge() const
+{
+    // The timer is coarse, leave some room so metadata
+    // a bit younger than the interval is still downloaded
+    return m_interval - m_interval / 10;
+}
+
+QVariantMap RefreshPolicy::stats() const
+{
+    QVariantList history;
+    for (const Record &record : m_history) {
+        QVariantMap entry;
+        entry[QLatin1String("time")] = record.time.toMSecsSinceEpoch() / 1000;
+        entry[QLatin1String("changed")] = record.changed;
+        entry[QLatin1String("security")] = record.security;
+        entry[QLatin1String("interval")] = record.interval;
+        history << entry;
+    }
+
+    QVariantMap ret;
+    ret[QLatin1String("interval")] = m_interval;
+    ret[QLatin1String("minInterval")] = m_minInterval;
+    ret[QLatin1String("maxInterval")] = m_maxInterval;
+    ret[QLatin1String("cacheAge")] = cacheAge();
+    ret[QLatin1String("history")] = history;
+    return ret;
+}
+
+void RefreshPolicy::load()
+{
+    KConfig state(QLatin1String(STATE_FILE), KConfig::SimpleConfig, QStandardPaths::GenericDataLocation);
+    KConfigGroup refreshGroup(&state, "Refresh");
+    m_interval = refreshGroup.readEntry("Interval", 0u);
+    m_userInterval = refreshGroup.readEntry("UserInterval", 0u);
+
+    // Each entry is "time changed security interval"
+    const QStringList history = refreshGroup.readEntry("History", QStringList());
+    for (const QString &entry : history) {
+        const QStringList fields = entry.split(QLatin1Char(' '));
+        if (fields.size() != 4) {
+            continue;
+        }
+
+        Record record;
+        record.time = QDateTime::fromMSecsSinceEpoch(fields.at(0).toLongLong() * 1000);
+        record.changed = fields.at(1).toInt();
+        record.security = fields.at(2).toInt();
+        record.interval = fields.at(3).toUInt();
+        m_history << record;
+    }
+}
+
+void RefreshPolicy::save() const
+{
+    QStringList history;
+    for (const Record &record : m_history) {
+        history << QString::number(record.time.toMSecsSinceEpoch() / 1000) + QLatin1Char(' ') +
+                   QString::number(record.changed) + QLatin1Char(' ') +
+                   QString::number(record.security) + QLatin1Char(' ') +
+                   QString::number(record.interval);
+    }
+
+    KConfig state(QLatin1String(STATE_FILE), KConfig::SimpleConfig, QStandardPaths::GenericDataLocation);
+    KConfigGroup refreshGroup(&state, "Refresh");
+    refreshGroup.writeEntry("Interval", m_interval);
+    refreshGroup.writeEntry("UserInterval", m_userInterval);
+    refreshGroup.writeEntry("History", history);
+}
@@ -0,0 +1,79 @@
+/***************************************************************************
+ *   Copyright (C) 2026 by agent                                           *
+ *   agent@local                                                           *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; see the file COPYING. If not, write to       *
+ *   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,  *
+ *   Boston, MA 02110-1301, USA.                                           *
+ ***************************************************************************/
+
+#ifndef REFRESHPOLICY_H
+#define REFRESHPOLICY_H
+
+#include <QDateTime>
+#include <QVariantMap>
+#include <QVector>
+
+/**
+ * Learns how often the repositories change.
+ *
+ * Each refresh records whether the set of updates changed after it,
+ * refreshes that find nothing stretch the interval and the ones that
+ * do shorten it, always within the bounds the user configured. New
+ * security updates go straight to the shortest interval.
+ */
+class RefreshPolicy
+{
+public:
+    RefreshPolicy();
+
+    /**
+     * interval is the user's refresh interval, min and max bound
+     * the learned one, 0 derives them from interval
+     */
+    void setBounds(uint interval, uint minInterval, uint maxInterval);
+
+    void recordRefresh(bool changed, bool security);
+
+    /**
+     * Seconds between refreshes
+     */
+    uint interval() const;
+    /**
+     * The cache-age hint that makes a refresh at interval()
+     * download the metadata again
+     */
+    uint cacheAge() const;
+
+    QVariantMap stats() const;
+
+private:
+    struct Record {
+        QDateTime time;
+        bool changed;
+        bool security;
+        uint interval;
+    };
+
+    void load();
+    void save() const;
+
+    uint m_interval = 0;
+    uint m_userInterval = 0;
+    uint m_minInterval = 0;
+    uint m_maxInterval = 0;
+    QVector<Record> m_history;
+};
+
+#endif // REFRESHPOLICY_H
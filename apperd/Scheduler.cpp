@@ -0,0 +1,121 @@
+/***************************************************************************
+ *   Copyright (C) 2026 by agent                                           *
+ *   agent@local                                                           *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; see the file COPYING. If not, write to       *
+ *   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,  *
+ *   Boston, MA 02110-1301, USA.                                           *
+ ***************************************************************************/
+
+#include "Scheduler.h"
+
+#include <QDBusConnection>
+#include <QTimer>
+
+#include <QLoggingCategory>
+
+// QTimer takes an int, long deadlines are approached a day at a time
+#define MAX_TIMER_INTERVAL (24 * 60 * 60 * 1000)
+
+Q_DECLARE_LOGGING_CATEGORY(APPER_DAEMON)
+
+Scheduler::Scheduler(QObject *parent) :
+    QObject(parent),
+    m_timer(new QTimer(this))
+{
+    m_timer->setSingleShot(true);
+    m_timer->setTimerType(Qt::VeryCoarseTimer);
+    connect(m_timer, &QTimer::timeout, this, &Scheduler::timeout);
+
+    QDBusConnection::systemBus().connect(QLatin1String("org.freedesktop.login1"),
+                                         QLatin1String("/org/freedesktop/login1"),
+                                         QLatin1String("org.freedesktop.login1.Manager"),
+                                         QLatin1String("PrepareForSleep"),
+                                         this,
+                                         SLOT(prepareForSleep(bool)));
+}
+
+Scheduler::~Scheduler()
+{
+}
+
+void Scheduler::schedule(Task task, const QDateTime &deadline)
+{
+    qCDebug(APPER_DAEMON) << "Scheduling" << task << "at" << deadline;
+    m_deadlines[task] = deadline;
+    rearm();
+}
+
+void Scheduler::cancel(Task task)
+{
+    if (m_deadlines.remove(task)) {
+        rearm();
+    }
+}
+
+QDateTime Scheduler::deadline(Task task) const
+{
+    return m_deadlines.value(task);
+}
+
+void Scheduler::timeout()
+{
+    const QDateTime now = QDateTime::currentDateTime();
+
+    QList<Task> dueTasks;
+    auto it = m_deadlines.begin();
+    while (it != m_deadlines.end()) {
+        if (it.value() <= now) {
+            dueTasks << static_cast<Task>(it.key());
+            it = m_deadlines.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    // Arm first, the handlers usually schedule the next run
+    rearm();
+    for (Task task : qAsConst(dueTasks)) {
+        emit due(task);
+    }
+}
+
+void Scheduler::prepareForSleep(bool active)
+{
+    if (!active) {
+        // Overdue tasks run right away
+        qCDebug(APPER_DAEMON) << "Resumed from suspend";
+        rearm();
+    }
+}
+
+void Scheduler::rearm()
+{
+    if (m_deadlines.isEmpty()) {
+        m_timer->stop();
+        return;
+    }
+
+    QDateTime next;
+    for (const QDateTime &deadline : qAsConst(m_deadlines)) {
+        if (next.isNull() || deadline < next) {
+            next = deadline;
+        }
+    }
+
+    const qint64 msecs = QDateTime::currentDateTime().msecsTo(next);
+    m_timer->start(static_cast<int>(qBound<qint64>(0, msecs, MAX_TIMER_INTERVAL)));
+}
+
+#include "moc_Scheduler.cpp"
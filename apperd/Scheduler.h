@@ -0,0 +1,73 @@
+/***************************************************************************
+ *   Copyright (C) 2026 by agent                                           *
+ *   agent@local                                                           *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; see the file COPYING. If not, write to       *
+ *   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,  *
+ *   Boston, MA 02110-1301, USA.                                           *
+ ***************************************************************************/
+
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <QObject>
+#include <QDateTime>
+#include <QHash>
+
+class QTimer;
+
+/**
+ * Runs apperd's periodic checks when they are due.
+ *
+ * Each task has a wall clock deadline and a single timer is armed for
+ * the earliest one, so apperd does not wake up in between. Timers
+ * don't count the time spent suspended, thus on resume the deadlines
+ * are checked again and the overdue ones run right away.
+ */
+class Scheduler : public QObject
+{
+    Q_OBJECT
+public:
+    enum Task {
+        TaskRefreshCache,
+        TaskDistroUpgrade,
+        TaskRebootCheck
+    };
+    Q_ENUM(Task)
+
+    explicit Scheduler(QObject *parent = nullptr);
+    ~Scheduler() override;
+
+    /**
+     * Replaces the deadline of task, a past one runs as soon as possible
+     */
+    void schedule(Task task, const QDateTime &deadline);
+    void cancel(Task task);
+    QDateTime deadline(Task task) const;
+
+Q_SIGNALS:
+    void due(Scheduler::Task task);
+
+private Q_SLOTS:
+    void timeout();
+    void prepareForSleep(bool active);
+
+private:
+    void rearm();
+
+    QHash<int, QDateTime> m_deadlines;
+    QTimer *m_timer;
+};
+
+#endif // SCHEDULER_H
@@ -27,6 +27,9 @@
 //#include <KGlobal>
 #include <KNotification>
 
+#include <QDBusPendingCallWatcher>
+#include <QDBusPendingReply>
+
 #include <QLoggingCategory>
 
 Q_DECLARE_LOGGING_CATEGORY(APPER_DAEMON)
@@ -179,12 +182,21 @@ bool TransactionJob::doKill()
     // emit the description so the Speed: xxx KiB/s
     // don't get confused to a destination URL
     emit description(this, PkStrings::action(m_role, m_flags));
-    QDBusPendingReply<> reply = m_transaction->cancel();
-    reply.waitForFinished();
-    qCDebug(APPER_DAEMON) << "Transaction cancel operation result" << m_transaction->tid().path() << reply.error();
-    emit canceled();
 
-    return !reply.isError() && m_transaction->role() == Transaction::RoleCancel;
+    // Don't wait for PackageKit to answer, the job finishes when
+    // the transaction does, which tells us if it was really canceled
+    auto call = new QDBusPendingCallWatcher(m_transaction->cancel(), this);
+    connect(call, &QDBusPendingCallWatcher::finished, this, [this] (QDBusPendingCallWatcher *call) {
+        call->deleteLater();
+
+        QDBusPendingReply<> reply = *call;
+        qCDebug(APPER_DAEMON) << "Transaction cancel operation result" << m_transaction->tid().path() << reply.error();
+        if (!reply.isError()) {
+            emit canceled();
+        }
+    });
+
+    return false;
 }
 
 #include "moc_TransactionJob.cpp"
@@ -0,0 +1,320 @@
+/***************************************************************************
+ *   Copyright (C) 2026 by agent                                           *
+ *   agent@local                                                           *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; see the file COPYING. If not, write to       *
+ *   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,  *
+ *   Boston, MA 02110-1301, USA.                                           *
+ ***************************************************************************/
+
+#include "TransactionStats.h"
+
+#include <Daemon>
+
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QTimer>
+
+#include <QLoggingCategory>
+
+#include <algorithm>
+
+Q_DECLARE_LOGGING_CATEGORY(APPER_DAEMON)
+
+// Samples kept, older ones are dropped
+#define MAX_SAMPLES   1000
+#define STATS_VERSION 1
+// Milliseconds new samples wait to be written together
+#define SAVE_DELAY    (60 * 1000)
+
+using namespace PackageKit;
+
+// Upper bounds of the histogram buckets in milliseconds,
+// values above the last one go in an extra bucket
+static const qint64 bucketBounds[] = {
+    100, 250, 500, 1000, 2500, 5000, 10000, 30000,
+    60000, 120000, 300000, 600000, 1800000
+};
+
+static QString statsFile()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::GenericDataLocation) + QLatin1String("/apperd/transactionstats");
+}
+
+TransactionStats::TransactionStats(QObject *parent) :
+    QObject(parent),
+    m_saveTimer(new QTimer(this))
+{
+    // Every transaction on the system ends up here, writing
+    // the file for each one would keep the main thread busy
+    m_saveTimer->setSingleShot(true);
+    m_saveTimer->setTimerType(Qt::VeryCoarseTimer);
+    m_saveTimer->setInterval(SAVE_DELAY);
+    connect(m_saveTimer, &QTimer::timeout, this, &TransactionStats::save);
+
+    load();
+}
+
+TransactionStats::~TransactionStats()
+{
+    if (m_saveTimer->isActive()) {
+        save();
+    }
+}
+
+void TransactionStats::watch(Transaction *transaction)
+{
+    if (m_pending.contains(transaction)) {
+        return;
+    }
+
+    Pending &pending = m_pending[transaction];
+    pending.seen.start();
+    connect(transaction, &Transaction::statusChanged, this, &TransactionStats::statusChanged);
+    connect(transaction, &Transaction::downloadSizeRemainingChanged, this, &TransactionStats::downloadSizeRemainingChanged);
+    connect(transaction, &Transaction::package, this, &TransactionStats::package);
+    connect(transaction, &Transaction::finished, this, &TransactionStats::finished);
+    connect(transaction, &Transaction::destroyed, this, [this, transaction] () {
+        m_pending.remove(transaction);
+    });
+}
+
+void TransactionStats::statusChanged()
+{
+    auto transaction = qobject_cast<Transaction*>(sender());
+    auto it = m_pending.find(transaction);
+    if (it == m_pending.end()) {
+        return;
+    }
+
+    Transaction::Status status = transaction->status();
+    if (it->queueWait == -1 && !isWaiting(status)) {
+        it->queueWait = it->seen.elapsed();
+    }
+
+    if (isDownloading(status)) {
+        if (!it->downloading.isValid()) {
+            it->downloading.start();
+        }
+    } else if (it->downloading.isValid()) {
+        it->download += it->downloading.elapsed();
+        it->downloading.invalidate();
+    }
+}
+
+void TransactionStats::downloadSizeRemainingChanged()
+{
+    auto transaction = qobject_cast<Transaction*>(sender());
+    auto it = m_pending.find(transaction);
+    if (it != m_pending.end()) {
+        // The largest value seen is what it downloads
+        it->bytes = qMax(it->bytes, transaction->downloadSizeRemaining());
+    }
+}
+
+void TransactionStats::package(Transaction::Info info, const QString &packageID)
+{
+    Q_UNUSED(info)
+
+    auto it = m_pending.find(qobject_cast<Transaction*>(sender()));
+    if (it != m_pending.end()) {
+        // Packages show up once for each step
+        it->packages << packageID;
+    }
+}
+
+void TransactionStats::finished(Transaction::Exit exit, uint runtime)
+{
+    auto transaction = qobject_cast<Transaction*>(sender());
+    auto it = m_pending.find(transaction);
+    if (it == m_pending.end()) {
+        return;
+    }
+
+    if (it->downloading.isValid()) {
+        it->download += it->downloading.elapsed();
+    }
+
+    Sample sample;
+    sample.time = QDateTime::currentMSecsSinceEpoch() / 1000;
+    sample.role = transaction->role();
+    sample.failed = exit != Transaction::ExitSuccess;
+    // A transaction that never left the queue waited all along
+    sample.queueWait = it->queueWait == -1 ? it->seen.elapsed() : it->queueWait;
+    sample.download = it->download;
+    sample.runtime = runtime;
+    sample.bytes = it->bytes;
+    sample.packages = it->packages.size();
+    m_pending.erase(it);
+
+    m_samples << sample;
+    if (m_samples.size() > MAX_SAMPLES) {
+        m_samples.remove(0, m_samples.size() - MAX_SAMPLES);
+    }
+    if (!m_saveTimer->isActive()) {
+        m_saveTimer->start();
+    }
+}
+
+QVariantMap TransactionStats::stats() const
+{
+    QHash<int, QVector<const Sample*> > byRole;
+    for (const Sample &sample : m_samples) {
+        byRole[sample.role] << &sample;
+    }
+
+    QVariantMap roles;
+    for (auto it = byRole.constBegin(); it != byRole.constEnd(); ++it) {
+        QVector<qint64> queueWait;
+        QVector<qint64> download;
+        QVector<qint64> runtime;
+        uint failed = 0;
+        qulonglong bytes = 0;
+        qulonglong packages = 0;
+        for (const Sample *sample : it.value()) {
+            queueWait << sample->queueWait;
+            download << sample->download;
+            runtime << sample->runtime;
+            failed += sample->failed;
+            bytes += sample->bytes;
+            packages += sample->packages;
+        }
+
+        QVariantMap role;
+        role[QLatin1String("count")] = uint(it.value().size());
+        role[QLatin1String("failed")] = failed;
+        role[QLatin1String("bytes")] = bytes;
+        role[QLatin1String("packages")] = packages;
+        role[QLatin1String("queueWait")] = histogram(queueWait);
+        role[QLatin1String("download")] = histogram(download);
+        role[QLatin1String("runtime")] = histogram(runtime);
+        roles[Daemon::enumToString<Transaction>(it.key(), "Role")] = role;
+    }
+
+    QVariantList buckets;
+    for (qint64 bound : bucketBounds) {
+        buckets << bound;
+    }
+
+    QVariantMap ret;
+    ret[QLatin1String("buckets")] = buckets;
+    ret[QLatin1String("roles")] = roles;
+    ret[QLatin1String("samples")] = uint(m_samples.size());
+    ret[QLatin1String("since")] = m_samples.isEmpty() ? Q_INT64_C(0) : m_samples.first().time;
+    return ret;
+}
+
+bool TransactionStats::isWaiting(Transaction::Status status)
+{
+    return status == Transaction::StatusUnknown ||
+            status == Transaction::StatusWait ||
+            status == Transaction::StatusWaitingForLock;
+}
+
+bool TransactionStats::isDownloading(Transaction::Status status)
+{
+    switch (status) {
+    case Transaction::StatusDownload:
+    case Transaction::StatusDownloadRepository:
+    case Transaction::StatusDownloadPackagelist:
+    case Transaction::StatusDownloadFilelist:
+    case Transaction::StatusDownloadChangelog:
+    case Transaction::StatusDownloadGroup:
+    case Transaction::StatusDownloadUpdateinfo:
+        return true;
+    default:
+        return false;
+    }
+}
+
+QVariantList TransactionStats::histogram(const QVector<qint64> &values)
+{
+    const int size = sizeof(bucketBounds) / sizeof(bucketBounds[0]);
+    QVector<uint> counts(size + 1, 0);
+    for (qint64 value : values) {
+        // The first bucket whose bound is above value
+        const int bucket = std::upper_bound(bucketBounds, bucketBounds + size, value) - bucketBounds;
+        ++counts[bucket];
+    }
+
+    QVariantList ret;
+    for (uint count : qAsConst(counts)) {
+        ret << count;
+    }
+    return ret;
+}
+
+void TransactionStats::load()
+{
+    QFile file(statsFile());
+    if (!file.open(QIODevice::ReadOnly)) {
+        return;
+    }
+
+    QDataStream stream(&file);
+    qint32 version;
+    qint32 count;
+    stream >> version >> count;
+    if (version != STATS_VERSION) {
+        return;
+    }
+
+    // Don't trust the count to size anything
+    count = qBound(0, count, MAX_SAMPLES);
+    m_samples.reserve(count);
+    for (int i = 0; i < count && stream.status() == QDataStream::Ok; ++i) {
+        Sample sample;
+        qint32 role;
+        qint32 packages;
+        stream >> sample.time >> role >> sample.failed >> sample.queueWait
+               >> sample.download >> sample.runtime >> sample.bytes >> packages;
+        sample.role = role;
+        sample.packages = packages;
+        m_samples << sample;
+    }
+
+    if (stream.status() != QDataStream::Ok) {
+        qCWarning(APPER_DAEMON) << "Discarding corrupted transaction stats" << file.fileName();
+        m_samples.clear();
+    }
+}
+
+void TransactionStats::save()
+{
+    m_saveTimer->stop();
+
+    const QString fileName = statsFile();
+    QDir().mkpath(QFileInfo(fileName).absolutePath());
+
+    QSaveFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qCWarning(APPER_DAEMON) << "Failed to save the transaction stats" << file.errorString();
+        return;
+    }
+
+    QDataStream stream(&file);
+    stream << qint32(STATS_VERSION) << qint32(m_samples.size());
+    for (const Sample &sample : m_samples) {
+        stream << sample.time << qint32(sample.role) << sample.failed << sample.queueWait
+               << sample.download << sample.runtime << sample.bytes << qint32(sample.packages);
+    }
+    file.commit();
+}
+
+#include "moc_TransactionStats.cpp"
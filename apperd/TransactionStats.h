@@ -0,0 +1,96 @@
+/***************************************************************************
+ *   Copyright (C) 2026 by agent                                           *
+ *   agent@local                                                           *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; see the file COPYING. If not, write to       *
+ *   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,  *
+ *   Boston, MA 02110-1301, USA.                                           *
+ ***************************************************************************/
+
+#ifndef TRANSACTIONSTATS_H
+#define TRANSACTIONSTATS_H
+
+#include <Transaction>
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QSet>
+#include <QVariantMap>
+#include <QVector>
+
+/**
+ * Keeps a rolling record of how long the transactions on this
+ * system took, so slow backends and operations can be spotted.
+ *
+ * Every transaction TransactionWatcher sees is timed: how long it
+ * waited in the queue, how long it spent downloading and its total
+ * runtime, with the bytes and packages it handled. The last samples
+ * are stored and summarized per role as histograms, new samples are
+ * written out together about a minute later.
+ */
+class QTimer;
+class TransactionStats : public QObject
+{
+    Q_OBJECT
+public:
+    explicit TransactionStats(QObject *parent = nullptr);
+    ~TransactionStats() override;
+
+    void watch(PackageKit::Transaction *transaction);
+
+    /**
+     * "buckets" has the upper bounds in milliseconds of the histogram
+     * buckets, the last one is open, "roles" maps each role to its
+     * count, failed, bytes, packages, queueWait, download and runtime
+     */
+    QVariantMap stats() const;
+
+private Q_SLOTS:
+    void statusChanged();
+    void downloadSizeRemainingChanged();
+    void package(PackageKit::Transaction::Info info, const QString &packageID);
+    void finished(PackageKit::Transaction::Exit exit, uint runtime);
+    void save();
+
+private:
+    struct Pending {
+        QElapsedTimer seen;
+        qint64 queueWait = -1;
+        QElapsedTimer downloading;
+        qint64 download = 0;
+        qulonglong bytes = 0;
+        QSet<QString> packages;
+    };
+    struct Sample {
+        qint64 time;
+        int role;
+        bool failed;
+        qint64 queueWait;
+        qint64 download;
+        qint64 runtime;
+        qulonglong bytes;
+        int packages;
+    };
+
+    static bool isWaiting(PackageKit::Transaction::Status status);
+    static bool isDownloading(PackageKit::Transaction::Status status);
+    static QVariantList histogram(const QVector<qint64> &values);
+    void load();
+
+    QHash<PackageKit::Transaction*, Pending> m_pending;
+    QVector<Sample> m_samples;
+    QTimer *m_saveTimer;
+};
+
+#endif // TRANSACTIONSTATS_H
@@ -21,6 +21,7 @@
 #include "TransactionWatcher.h"
 
 #include "TransactionJob.h"
+#include "TransactionStats.h"
 
 #include <PkStrings.h>
 #include <PkIcons.h>
@@ -35,6 +36,8 @@
 //#include <Solid/PowerManagement>
 #include <QtDBus/QDBusMessage>
 #include <QtDBus/QDBusConnection>
+#include <QtDBus/QDBusPendingCallWatcher>
+#include <QtDBus/QDBusPendingReply>
 
 #include <kworkspace5/kworkspace.h>
 #include <Daemon>
@@ -43,31 +46,48 @@
 
 Q_DECLARE_LOGGING_CATEGORY(APPER_DAEMON)
 
-TransactionWatcher::TransactionWatcher(bool packagekitIsRunning, QObject *parent) :
+TransactionWatcher::TransactionWatcher(QObject *parent) :
     QObject(parent),
     m_inhibitCookie(-1)
 {
     m_tracker = new KUiServerJobTracker(this);
+    m_stats = new TransactionStats(this);
 
     // keep track of new transactions
     connect(Daemon::global(), &Daemon::transactionListChanged, this, &TransactionWatcher::transactionListChanged);
+}
+
+TransactionWatcher::~TransactionWatcher()
+{
+    // release any cookie that we might have
+    suppressSleep(false, m_inhibitCookie);
+}
+
+TransactionStats *TransactionWatcher::stats() const
+{
+    return m_stats;
+}
+
+void TransactionWatcher::watchRunningTransactions()
+{
+    auto call = new QDBusPendingCallWatcher(Daemon::global()->getTransactionList(), this);
+    connect(call, &QDBusPendingCallWatcher::finished, this, [this] (QDBusPendingCallWatcher *call) {
+        call->deleteLater();
+
+        QDBusPendingReply<QList<QDBusObjectPath> > reply = *call;
+        if (reply.isError()) {
+            qCWarning(APPER_DAEMON) << "Failed to get the running transactions" << reply.error().message();
+            return;
+        }
 
-    // if PackageKit is running check to see if there are running transactons already
-    if (packagekitIsRunning) {
         // here we check whether a transaction job should be created or not
         QStringList tids;
-        const QList<QDBusObjectPath> paths = Daemon::global()->getTransactionList();
+        const QList<QDBusObjectPath> paths = reply.value();
         for (const QDBusObjectPath &path : paths) {
             tids << path.path();
         }
         transactionListChanged(tids);
-    }
-}
-
-TransactionWatcher::~TransactionWatcher()
-{
-    // release any cookie that we might have
-    suppressSleep(false, m_inhibitCookie);
+    });
 }
 
 void TransactionWatcher::watchTransactionInteractive(const QDBusObjectPath &tid)
@@ -95,6 +115,7 @@ void TransactionWatcher::watchTransaction(const QDBusObjectPath &tid, bool inter
         transaction = new Transaction(tid);
         connect(transaction, &Transaction::roleChanged, this, &TransactionWatcher::transactionReady);
         connect(transaction, &Transaction::finished, this, &TransactionWatcher::finished);
+        m_stats->watch(transaction);
 
         // Store the transaction id
         m_transactions[tid] = transaction;
@@ -32,14 +32,22 @@
 using namespace PackageKit;
 
 class TransactionJob;
+class TransactionStats;
 class TransactionWatcher : public QObject
 {
     Q_OBJECT
 public:
-    explicit TransactionWatcher(bool packagekitIsRunning, QObject *parent = nullptr);
+    explicit TransactionWatcher(QObject *parent = nullptr);
     ~TransactionWatcher() override;
 
+    TransactionStats *stats() const;
+
 public Q_SLOTS:
+    /**
+     * Asks PackageKit for the transactions already running,
+     * without waiting for the reply
+     */
+    void watchRunningTransactions();
     void watchTransactionInteractive(const QDBusObjectPath &tid);
     void watchTransaction(const QDBusObjectPath &tid, bool interactive = true);
     void transactionReady();
@@ -67,6 +75,7 @@ private:
     // cookie to suppress sleep
     int           m_inhibitCookie;
     KUiServerJobTracker *m_tracker;
+    TransactionStats *m_stats;
 };
 
 #endif
@@ -23,6 +23,9 @@
 #include "Updater.h"
 
 #include "ApperdThread.h"
+#include "OfflineUpdateTask.h"
+#include "PreDownloader.h"
+#include "PressureMonitor.h"
 
 #include <Daemon>
 
@@ -32,24 +35,59 @@
 
 #include <QDBusServiceWatcher>
 #include <QDBusMessage>
+#include <QDBusPendingCallWatcher>
+#include <QDBusPendingReply>
+#include <QCryptographicHash>
+#include <QStandardPaths>
+#include <QtEndian>
 
 #include <KLocalizedString>
 #include <KNotification>
 #include <KActionCollection>
 #include <KToolInvocation>
+#include <KConfig>
+#include <KConfigGroup>
 
 #include <QLoggingCategory>
 
 Q_DECLARE_LOGGING_CATEGORY(APPER_DAEMON)
 
 #define UPDATES_ICON "system-software-update"
+#define STATE_FILE   "apperdstaterc"
 
 using namespace PackageKit;
 
 Updater::Updater(QObject* parent) :
     QObject(parent),
+    m_systemReady(false),
     m_getUpdatesT(nullptr)
 {
+    // Automatic updates wait for the system to calm down
+    m_pressure = new PressureMonitor(this);
+    connect(m_pressure, &PressureMonitor::calm, this, &Updater::pressureCalm);
+
+    // Downloads ahead of time in DownloadOnly mode
+    m_preDownloader = new PreDownloader(this);
+    connect(m_preDownloader, &PreDownloader::finished, this, &Updater::preDownloadFinished);
+    connect(m_preDownloader, &PreDownloader::failed, this, [this] () {
+        if (!isNotified(m_updateList)) {
+            // Let the user install them live instead
+            showUpdatesPopup();
+        }
+    });
+
+    // Stages the downloaded updates for the next reboot
+    m_offlineUpdate = new OfflineUpdateTask(this);
+    connect(m_offlineUpdate, &OfflineUpdateTask::reviewUpdates, this, &Updater::reviewUpdates);
+    connect(m_offlineUpdate, &OfflineUpdateTask::prepared, this, [this] () {
+        // The user was told the updates are ready
+        setNotified(m_updateList);
+    });
+    connect(m_offlineUpdate, &OfflineUpdateTask::failed, this, [this] () {
+        // Let the user install them live instead
+        showUpdatesPopup();
+    });
+
     // in case registration fails due to another user or application running
     // keep an eye on it so we can register when available
     auto watcher = new QDBusServiceWatcher(QLatin1String("org.kde.ApperUpdaterIcon"),
@@ -58,8 +96,24 @@ Updater::Updater(QObject* parent) :
                                            this);
     connect(watcher, &QDBusServiceWatcher::serviceOwnerChanged, this, &Updater::serviceOwnerChanged);
 
-    m_hasAppletIconified = ApperdThread::nameHasOwner(QLatin1String("org.kde.ApperUpdaterIcon"),
-                                                      QDBusConnection::sessionBus());
+    m_hasAppletIconified = false;
+    auto call = ApperdThread::nameHasOwner(QLatin1String("org.kde.ApperUpdaterIcon"),
+                                           QDBusConnection::sessionBus(),
+                                           this);
+    connect(call, &QDBusPendingCallWatcher::finished, this, [this] (QDBusPendingCallWatcher *call) {
+        QDBusPendingReply<bool> reply = *call;
+        // The watcher might have told us already
+        m_hasAppletIconified = m_hasAppletIconified || (reply.isValid() && reply.value());
+        call->deleteLater();
+    });
+
+    // What we published and notified before
+    // apperd was restarted or the user logged out
+    KConfig state(QLatin1String(STATE_FILE), KConfig::SimpleConfig, QStandardPaths::GenericDataLocation);
+    KConfigGroup updatesGroup(&state, "Updates");
+    m_generation = updatesGroup.readEntry("Generation", 0u);
+    m_fingerprint = updatesGroup.readEntry("Fingerprint", QString());
+    m_notifiedFingerprint = updatesGroup.readEntry("NotifiedFingerprint", QString());
 }
 
 Updater::~Updater()
@@ -69,6 +123,11 @@ Updater::~Updater()
 void Updater::setConfig(const QVariantHash &configs)
 {
     m_configs = configs;
+    m_pressure->setMaxPressure(configs[QLatin1String(CFG_MAX_PRESSURE)].toDouble());
+    m_pressure->setMaxLoad(configs[QLatin1String(CFG_MAX_LOAD)].toDouble());
+    m_pressure->setCalmPeriod(configs[QLatin1String(CFG_CALM_PERIOD)].toInt());
+    m_preDownloader->setConfig(configs);
+    updatePreDownloader();
 }
 
 void Updater::setSystemReady()
@@ -76,12 +135,50 @@ void Updater::setSystemReady()
     // System ready changed, maybe we can auto
     // install some updates
     m_systemReady = true;
+    updatePreDownloader();
     getUpdateFinished();
 }
 
+void Updater::updatePreDownloader()
+{
+    uint updateType = m_configs[QLatin1String(CFG_AUTO_UP)].value<uint>();
+    m_preDownloader->setEnabled(m_systemReady && updateType == Enum::DownloadOnly);
+}
+
+void Updater::pressureCalm()
+{
+    // A running check ends up there anyway
+    if (!m_getUpdatesT) {
+        getUpdateFinished();
+    }
+}
+
+void Updater::preDownloadFinished()
+{
+    // Reported again after each check, but the
+    // user only needs to hear about it once
+    if (m_updateList.isEmpty() || isNotified(m_updateList)) {
+        return;
+    }
+
+    if (m_configs[QLatin1String(CFG_PREPARE_OFFLINE)].value<bool>()) {
+        // The user gets told once they are staged
+        prepareOfflineUpdate();
+    } else {
+        // We finished downloading show the updates to the user
+        showUpdatesPopup();
+    }
+}
+
+void Updater::prepareOfflineUpdate()
+{
+    m_offlineUpdate->prepare(m_updateList);
+}
+
 void Updater::checkForUpdates(bool systemReady)
 {
     m_systemReady = systemReady;
+    updatePreDownloader();
 
     // Skip the check if one is already running or
     // the plasmoid is in Icon form and the auto update type is None
@@ -92,14 +189,20 @@ void Updater::checkForUpdates(bool systemReady)
     m_updateList.clear();
     m_importantList.clear();
     m_securityList.clear();
+    m_pendingUpdates.clear();
     m_getUpdatesT = Daemon::getUpdates();
     connect(m_getUpdatesT, &Transaction::package, this, &Updater::packageToUpdate);
+    connect(m_getUpdatesT, &Transaction::finished, this, &Updater::publishUpdates);
     connect(m_getUpdatesT, &Transaction::finished, this, &Updater::getUpdateFinished);
 }
 
 void Updater::packageToUpdate(Transaction::Info info, const QString &packageID, const QString &summary)
 {
-    Q_UNUSED(summary)
+    UpdateItem item;
+    item.info = info;
+    item.packageID = packageID;
+    item.summary = summary;
+    m_pendingUpdates << item;
 
     switch (info) {
     case Transaction::InfoBlocked:
@@ -118,26 +221,42 @@ void Updater::packageToUpdate(Transaction::Info info, const QString &packageID,
     m_updateList << packageID;
 }
 
+void Updater::publishUpdates(Transaction::Exit status)
+{
+    if (status != Transaction::ExitSuccess) {
+        // Keep publishing the last good list
+        m_pendingUpdates.clear();
+        return;
+    }
+
+    QStringList keys;
+    keys.reserve(m_pendingUpdates.size());
+    for (const UpdateItem &item : qAsConst(m_pendingUpdates)) {
+        keys << QString::number(item.info) + QLatin1Char(' ') + item.packageID;
+    }
+    const QString newFingerprint = fingerprint(keys);
+
+    // The first list is always news, even if empty
+    if (m_generation == 0 || newFingerprint != m_fingerprint) {
+        ++m_generation;
+        m_fingerprint = newFingerprint;
+        saveState();
+    }
+    m_updates = m_pendingUpdates;
+    m_pendingUpdates.clear();
+    m_preDownloader->setUpdates(m_updates);
+    emit updatesListed(m_updates, m_generation, m_fingerprint);
+}
+
 void Updater::getUpdateFinished()
 {
     m_getUpdatesT = nullptr;
     if (!m_updateList.isEmpty()) {
         auto transaction = qobject_cast<Transaction*>(sender());
 
-        bool different = false;
-        if (m_oldUpdateList.size() != m_updateList.size()) {
-            different = true;
-        } else {
-            // The lists have the same size let's make sure
-            // all the packages are the same
-            const QStringList updates = m_updateList;
-            for (const QString &packageId : updates) {
-                if (!m_oldUpdateList.contains(packageId)) {
-                    different = true;
-                    break;
-                }
-            }
-        }
+        // This survives restarts, so logging in again doesn't
+        // notify or auto update the same packages again
+        bool different = !isNotified(m_updateList);
 
         // sender is not a transaction when we systemReady has changed
         // if the lists are the same don't show
@@ -147,6 +266,17 @@ void Updater::getUpdateFinished()
         }
 
         uint updateType = m_configs[QLatin1String(CFG_AUTO_UP)].value<uint>();
+        bool autoInstall = updateType == Enum::All ||
+                           (updateType == Enum::Security && !m_securityList.isEmpty());
+        bool autoUpdate = autoInstall || updateType == Enum::DownloadOnly;
+        if (m_systemReady && autoInstall && !m_pressure->isCalm()) {
+            // Don't compete with a compile or a video call,
+            // the user gets notified once the updates start
+            qCDebug(APPER_DAEMON) << "Deferring automatic updates until the system is less busy";
+            m_pressure->waitForCalm();
+            return;
+        }
+
         if (m_systemReady && updateType == Enum::All) {
             // update all
             bool ret;
@@ -168,19 +298,11 @@ void Updater::getUpdateFinished()
                 return;
             }
         } else if (m_systemReady && updateType == Enum::DownloadOnly) {
-            // Download all updates
-            bool ret;
-            ret = updatePackages(m_updateList,
-                                 true,
-                                 QLatin1String("download"),
-                                 i18n("Updates are being automatically downloaded."));
-            if (ret) {
-                return;
-            }
-        } else if (!m_systemReady &&
-                   (updateType == Enum::All ||
-                    updateType == Enum::DownloadOnly ||
-                    (updateType == Enum::Security && !m_securityList.isEmpty()))) {
+            // The pre-downloader is fetching them in the background, once
+            // they are all downloaded they are offered or, if asked for,
+            // staged for an offline update
+            return;
+        } else if (!m_systemReady && autoUpdate) {
             qCDebug(APPER_DAEMON) << "Not auto updating or downloading, as we might be on battery or mobile connection";
         }
 
@@ -191,7 +313,7 @@ void Updater::getUpdateFinished()
             showUpdatesPopup();
         }
     } else {
-        m_oldUpdateList.clear();
+        setNotified(QStringList());
     }
 }
 
@@ -214,7 +336,16 @@ void Updater::autoUpdatesFinished(PkTransaction::ExitStatus status)
         QIcon icon = QIcon::fromTheme(QLatin1String("dialog-cancel"));
         // use of QSize does the right thing
         notify->setPixmap(icon.pixmap(KPK_ICON_SIZE, KPK_ICON_SIZE));
-        notify->setText(i18n("The software update failed."));
+        const QStringList left = qobject_cast<PkTransaction*>(sender())->resumePackages();
+        if (left.isEmpty()) {
+            notify->setText(i18n("The software update failed."));
+        } else {
+            // The batches before the failing one are installed, the
+            // updates list will only have what was left
+            notify->setText(i18np("The software update failed, one update was not installed.",
+                                  "The software update failed, %1 updates were not installed.",
+                                  left.size()));
+        }
         notify->sendEvent();
 
         // show updates popup
@@ -230,15 +361,31 @@ void Updater::reviewUpdates()
                                                  QLatin1String("/"),
                                                  QLatin1String("org.kde.ApperUpdaterIcon"),
                                                  QLatin1String("ReviewUpdates"));
-        QDBusMessage reply = QDBusConnection::sessionBus().call(message);
-        if (reply.type() == QDBusMessage::ReplyMessage) {
-            return;
-        }
-        qCWarning(APPER_DAEMON) << "Message did not receive a reply";
+        auto call = new QDBusPendingCallWatcher(QDBusConnection::sessionBus().asyncCall(message), this);
+        connect(call, &QDBusPendingCallWatcher::finished, this, [] (QDBusPendingCallWatcher *call) {
+            call->deleteLater();
+            if (call->isError()) {
+                qCWarning(APPER_DAEMON) << "Message did not receive a reply" << call->error().message();
+                startUpdatesReview();
+            }
+        });
+        return;
     }
 
-    // This must be called from the main thread...
-    KToolInvocation::startServiceByDesktopName(QLatin1String("apper_updates"));
+    startUpdatesReview();
+}
+
+void Updater::startUpdatesReview()
+{
+    // This must be called from the main thread, don't
+    // wait for the KCM to come up
+    KToolInvocation::startServiceByDesktopName(QLatin1String("apper_updates"),
+                                               QStringList(),
+                                               nullptr,
+                                               nullptr,
+                                               nullptr,
+                                               QByteArray(),
+                                               true);
 }
 
 void Updater::installUpdates()
@@ -260,9 +407,44 @@ void Updater::serviceOwnerChanged(const QString &service, const QString &oldOwne
     m_hasAppletIconified = !newOwner.isEmpty();
 }
 
+QString Updater::fingerprint(const QStringList &keys)
+{
+    // Adding the hashes up makes the order irrelevant, qHash()
+    // can't be used as it is seeded differently on each run
+    quint64 sum = 0;
+    for (const QString &key : keys) {
+        const QByteArray hash = QCryptographicHash::hash(key.toUtf8(), QCryptographicHash::Sha1);
+        sum += qFromLittleEndian<quint64>(reinterpret_cast<const uchar*>(hash.constData()));
+    }
+    return QString::number(keys.size()) + QLatin1Char('-') + QString::number(sum, 16);
+}
+
+bool Updater::isNotified(const QStringList &updates) const
+{
+    return fingerprint(updates) == m_notifiedFingerprint;
+}
+
+void Updater::setNotified(const QStringList &updates)
+{
+    const QString notified = fingerprint(updates);
+    if (notified != m_notifiedFingerprint) {
+        m_notifiedFingerprint = notified;
+        saveState();
+    }
+}
+
+void Updater::saveState()
+{
+    KConfig state(QLatin1String(STATE_FILE), KConfig::SimpleConfig, QStandardPaths::GenericDataLocation);
+    KConfigGroup updatesGroup(&state, "Updates");
+    updatesGroup.writeEntry("Generation", m_generation);
+    updatesGroup.writeEntry("Fingerprint", m_fingerprint);
+    updatesGroup.writeEntry("NotifiedFingerprint", m_notifiedFingerprint);
+}
+
 void Updater::showUpdatesPopup()
 {
-    m_oldUpdateList = m_updateList;
+    setNotified(m_updateList);
 
     auto notify = new KNotification(QLatin1String("ShowUpdates"), nullptr, KNotification::Persistent);
     notify->setComponentName(QLatin1String("apperd"));
@@ -297,12 +479,15 @@ void Updater::showUpdatesPopup()
 
 bool Updater::updatePackages(const QStringList &packages, bool downloadOnly, const QString &icon, const QString &msg)
 {
-    m_oldUpdateList = m_updateList;
+    setNotified(m_updateList);
 
     // Defaults to security
     auto transaction = new PkTransaction;
     transaction->setProperty("DownloadOnly", downloadOnly);
     transaction->enableJobWatcher(true);
+    // Only automatic updates have an icon, those were not
+    // asked for and must not slow down what the user is doing
+    transaction->setBackground(!icon.isNull());
     transaction->updatePackages(packages, downloadOnly);
     connect(transaction, &PkTransaction::finished, this, &Updater::autoUpdatesFinished);
     if (!icon.isNull()) {
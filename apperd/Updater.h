@@ -24,11 +24,15 @@
 #define UPDATER_H
 
 #include <PkTransaction.h>
+#include <UpdateItem.h>
 
 #include <QStringList>
 
 using namespace PackageKit;
 
+class OfflineUpdateTask;
+class PreDownloader;
+class PressureMonitor;
 class Updater : public QObject
 {
     Q_OBJECT
@@ -41,27 +45,62 @@ public:
 
 public Q_SLOTS:
     void checkForUpdates(bool systemReady);
+    /**
+     * Downloads the updates and stages them
+     * to be installed on the next reboot
+     */
+    void prepareOfflineUpdate();
+
+Q_SIGNALS:
+    /**
+     * Emitted after each successful check, generation
+     * only changes when the set of updates changed
+     */
+    void updatesListed(const UpdateItemList &updates, uint generation, const QString &fingerprint);
 
 private Q_SLOTS:
     void packageToUpdate(PackageKit::Transaction::Info info, const QString &packageID, const QString &summary);
+    void publishUpdates(PackageKit::Transaction::Exit status);
     void getUpdateFinished();
+    void pressureCalm();
+    void preDownloadFinished();
     void autoUpdatesFinished(PkTransaction::ExitStatus exit);
     void reviewUpdates();
     void installUpdates();
     void serviceOwnerChanged(const QString &service, const QString &oldOwner, const QString &newOwner);
 
 private:
+    /**
+     * A hash of keys that doesn't depend on their order,
+     * stable across runs so it can be stored
+     */
+    static QString fingerprint(const QStringList &keys);
+    bool isNotified(const QStringList &updates) const;
+    void setNotified(const QStringList &updates);
+    void saveState();
     void showUpdatesPopup();
+    static void startUpdatesReview();
+    void updatePreDownloader();
     bool updatePackages(const QStringList &packages, bool downloadOnly, const QString &icon = QString(), const QString &msg = QString());
 
     bool m_hasAppletIconified;
     bool m_systemReady;
     Transaction *m_getUpdatesT;
-    QStringList m_oldUpdateList;
+    // Fingerprint of the updates the user was last told about
+    QString m_notifiedFingerprint;
     QStringList m_updateList;
     QStringList m_importantList;
     QStringList m_securityList;
+    // What apperd publishes on D-Bus, with all the packages
+    // PackageKit listed, blocked ones included
+    UpdateItemList m_updates;
+    UpdateItemList m_pendingUpdates;
+    uint m_generation = 0;
+    QString m_fingerprint;
     QVariantHash m_configs;
+    PressureMonitor *m_pressure;
+    PreDownloader *m_preDownloader;
+    OfflineUpdateTask *m_offlineUpdate;
 };
 
 #endif
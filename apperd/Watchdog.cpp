@@ -0,0 +1,111 @@
+/***************************************************************************
+ *   Copyright (C) 2026 by agent                                           *
+ *   agent@local                                                           *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; see the file COPYING. If not, write to       *
+ *   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,  *
+ *   Boston, MA 02110-1301, USA.                                           *
+ ***************************************************************************/
+
+#include "Watchdog.h"
+
+#include <QThread>
+#include <QTimer>
+
+#include <QLoggingCategory>
+
+#define WATCHDOG_INTERVAL 2000
+// Stalls above this are worth a warning
+#define WATCHDOG_WARN     1000
+
+Q_DECLARE_LOGGING_CATEGORY(APPER_DAEMON)
+
+Watchdog::Watchdog(QObject *parent) :
+    QObject(parent),
+    m_thread(new QThread(this)),
+    m_sent(-1),
+    m_longest(0),
+    m_last(0)
+{
+    m_clock.start();
+
+    // The timer lives on the watchdog thread, so it keeps
+    // ticking while the main thread is blocked
+    auto timer = new QTimer;
+    timer->setInterval(WATCHDOG_INTERVAL);
+    timer->setTimerType(Qt::CoarseTimer);
+    timer->moveToThread(m_thread);
+    connect(timer, &QTimer::timeout, timer, [this] () {
+        ping();
+    });
+    connect(m_thread, &QThread::started, timer, static_cast<void (QTimer::*)()>(&QTimer::start));
+    connect(m_thread, &QThread::finished, timer, &QObject::deleteLater);
+    m_thread->setObjectName(QLatin1String("apperd watchdog"));
+    m_thread->start(QThread::LowPriority);
+}
+
+Watchdog::~Watchdog()
+{
+    m_thread->quit();
+    m_thread->wait();
+}
+
+qint64 Watchdog::longestStall() const
+{
+    return m_longest.load();
+}
+
+qint64 Watchdog::lastStall() const
+{
+    return m_last.load();
+}
+
+void Watchdog::ping()
+{
+    // Watchdog thread
+    const qint64 sent = m_sent.load();
+    if (sent != -1) {
+        // Still waiting for the last pong
+        record(m_clock.elapsed() - sent);
+        return;
+    }
+
+    m_sent.store(m_clock.elapsed());
+    QMetaObject::invokeMethod(this, "pong", Qt::QueuedConnection);
+}
+
+void Watchdog::pong()
+{
+    // Main thread
+    const qint64 sent = m_sent.fetchAndStoreOrdered(-1);
+    if (sent != -1) {
+        const qint64 stall = m_clock.elapsed() - sent;
+        if (stall >= WATCHDOG_WARN) {
+            qCWarning(APPER_DAEMON) << "Main thread stalled for" << stall << "ms";
+        }
+        record(stall);
+    }
+}
+
+void Watchdog::record(qint64 stall)
+{
+    m_last.store(stall);
+
+    qint64 longest = m_longest.load();
+    while (stall > longest && !m_longest.testAndSetOrdered(longest, stall)) {
+        longest = m_longest.load();
+    }
+}
+
+#include "moc_Watchdog.cpp"
@@ -0,0 +1,64 @@
+/***************************************************************************
+ *   Copyright (C) 2026 by agent                                           *
+ *   agent@local                                                           *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; see the file COPYING. If not, write to       *
+ *   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,  *
+ *   Boston, MA 02110-1301, USA.                                           *
+ ***************************************************************************/
+
+#ifndef WATCHDOG_H
+#define WATCHDOG_H
+
+#include <QObject>
+#include <QAtomicInteger>
+#include <QElapsedTimer>
+
+class QThread;
+
+/**
+ * Measures how long kded's main thread stays unresponsive.
+ *
+ * A thread of its own pings the main thread every few seconds and
+ * records how late the answer comes back, a ping still unanswered
+ * on the next tick counts as a stall in progress.
+ */
+class Watchdog : public QObject
+{
+    Q_OBJECT
+public:
+    explicit Watchdog(QObject *parent = nullptr);
+    ~Watchdog() override;
+
+    /**
+     * Longest and most recent stall in milliseconds
+     */
+    qint64 longestStall() const;
+    qint64 lastStall() const;
+
+private Q_SLOTS:
+    void pong();
+
+private:
+    void ping();
+    void record(qint64 stall);
+
+    QThread *m_thread;
+    QElapsedTimer m_clock;
+    QAtomicInteger<qint64> m_sent;
+    QAtomicInteger<qint64> m_longest;
+    QAtomicInteger<qint64> m_last;
+};
+
+#endif // WATCHDOG_H
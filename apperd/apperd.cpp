@@ -28,24 +28,15 @@ Q_LOGGING_CATEGORY(APPER_DAEMON, "apper.daemon")
 ApperD::ApperD(QObject *parent, const QList<QVariant> &) :
     KDEDModule(parent)
 {
-//    m_thread = new QThread(this);
-    m_apperThread = new ApperdThread;
-//    m_apperThread->moveToThread(m_thread);
-//    m_thread->start();
-
-    // Make all our init code run on the thread since
-    // the DBus calls were made blocking
+    // Everything stays on kded's main thread, notifications, the
+    // debconf dialogs and the PkTransaction UI all need it, so
+    // nothing in ApperdThread may block waiting for a D-Bus reply
+    m_apperThread = new ApperdThread(this);
     QTimer::singleShot(0, m_apperThread, SLOT(init()));
 }
 
 ApperD::~ApperD()
 {
-    // delete the apper thread code, don't use delete later since it has moved
-    // to the stopped thread
-    m_apperThread->deleteLater();
-//    m_thread->quit();
-//    m_thread->wait();
-//    delete m_thread;
 }
 
 #include "moc_apperd.cpp"
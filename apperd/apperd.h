@@ -24,8 +24,6 @@
 #include <KDEDModule>
 #include <KPluginFactory>
 
-#include <QThread>
-
 class ApperdThread;
 class ApperD : public KDEDModule
 {
@@ -36,7 +34,6 @@ public:
     ~ApperD() override;
 
 private:
-    QThread *m_thread;
     ApperdThread *m_apperThread;
 };
 
@@ -0,0 +1,119 @@
+/***************************************************************************
+ *   Copyright (C) 2026 by agent                                           *
+ *   agent@local                                                           *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; see the file COPYING. If not, write to       *
+ *   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,  *
+ *   Boston, MA 02110-1301, USA.                                           *
+ ***************************************************************************/
+
+#include "ChangelogRenderer.h"
+
+#include <QTest>
+
+class ChangelogRendererTest : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void toHtml_data();
+    void toHtml();
+    void truncate();
+    void untouchedWhenShort();
+};
+
+void ChangelogRendererTest::toHtml_data()
+{
+    QTest::addColumn<QString>("text");
+    QTest::addColumn<QString>("html");
+
+    QTest::newRow("empty") << QString() << QString();
+    QTest::newRow("plain") << QStringLiteral("Fix a crash") << QStringLiteral("Fix a crash");
+    QTest::newRow("escaping")
+            << QStringLiteral("a < b && c > \"d\"")
+            << QStringLiteral("a &lt; b &amp;&amp; c &gt; &quot;d&quot;");
+    QTest::newRow("line breaks")
+            << QStringLiteral("one\ntwo\n")
+            << QStringLiteral("one<br/>two<br/>");
+    QTest::newRow("indentation")
+            << QStringLiteral("  indented")
+            << QStringLiteral("&nbsp;&nbsp;indented");
+    QTest::newRow("columns")
+            << QStringLiteral("a  b")
+            << QStringLiteral("a &nbsp;b");
+    QTest::newRow("heading")
+            << QStringLiteral("## Changes")
+            << QStringLiteral("<b>Changes</b>");
+    QTest::newRow("not a heading")
+            << QStringLiteral("#123 fixed")
+            << QStringLiteral("#123 fixed");
+    QTest::newRow("list items")
+            << QStringLiteral("- one\n* two\n+ three")
+            << QString::fromUtf8("\xE2\x80\xA2 one<br/>\xE2\x80\xA2 two<br/>\xE2\x80\xA2 three");
+    QTest::newRow("bold")
+            << QStringLiteral("a **bold** word")
+            << QStringLiteral("a <b>bold</b> word");
+    QTest::newRow("unclosed bold")
+            << QStringLiteral("2 ** 3")
+            << QStringLiteral("2 ** 3");
+    QTest::newRow("code")
+            << QStringLiteral("run `make **all**`")
+            << QStringLiteral("run <tt>make **all**</tt>");
+    QTest::newRow("link")
+            << QStringLiteral("see https://bugs.kde.org/1?a=1&b=2 now")
+            << QStringLiteral("see <a href=\"https://bugs.kde.org/1?a=1&amp;b=2\">https://bugs.kde.org/1?a=1&amp;b=2</a> now");
+    QTest::newRow("link in parentheses")
+            << QStringLiteral("(http://kde.org)")
+            << QStringLiteral("(<a href=\"http://kde.org\">http://kde.org</a>)");
+    QTest::newRow("not a link")
+            << QStringLiteral("xhttp://kde.org")
+            << QStringLiteral("xhttp://kde.org");
+}
+
+void ChangelogRendererTest::toHtml()
+{
+    QFETCH(QString, text);
+    QFETCH(QString, html);
+
+    bool truncated = true;
+    QCOMPARE(ChangelogRenderer::toHtml(text, 0, &truncated), html);
+    QVERIFY(!truncated);
+}
+
+void ChangelogRendererTest::truncate()
+{
+    const QString text = QStringLiteral("first line\nsecond line\nthird line");
+
+    // Cut on the last line break before the limit
+    bool truncated = false;
+    QCOMPARE(ChangelogRenderer::toHtml(text, 15, &truncated), QStringLiteral("first line"));
+    QVERIFY(truncated);
+
+    // Without a line break the limit itself is used
+    const QString word(100, QLatin1Char('x'));
+    QCOMPARE(ChangelogRenderer::toHtml(word, 10, &truncated), QString(10, QLatin1Char('x')));
+    QVERIFY(truncated);
+}
+
+void ChangelogRendererTest::untouchedWhenShort()
+{
+    const QString text = QStringLiteral("short\ntext");
+    bool truncated = true;
+    QCOMPARE(ChangelogRenderer::toHtml(text, 1000, &truncated), QStringLiteral("short<br/>text"));
+    QVERIFY(!truncated);
+    QCOMPARE(ChangelogRenderer::toHtml(text, 1000), ChangelogRenderer::toHtml(text));
+}
+
+QTEST_GUILESS_MAIN(ChangelogRendererTest)
+
+#include "ChangelogRendererTest.moc"
@@ -0,0 +1,238 @@
+/***************************************************************************
+ *   Copyright (C) 2026 by agent                                           *
+ *   agent@local                                                           *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; see the file COPYING. If not, write to       *
+ *   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,  *
+ *   Boston, MA 02110-1301, USA.                                           *
+ ***************************************************************************/
+
+#include "ScreenshotCache.h"
+
+#include <QFile>
+#include <QLoggingCategory>
+#include <QScopedPointer>
+#include <QSignalSpy>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QTemporaryDir>
+#include <QTest>
+
+Q_LOGGING_CATEGORY(APPER, "apper")
+
+/**
+ * Loopback HTTP server answering every path with a fixed body
+ * and an ETag, and with 304 when the client already has it
+ */
+class HttpServer : public QTcpServer
+{
+    Q_OBJECT
+public:
+    HttpServer()
+    {
+        connect(this, &QTcpServer::newConnection, this, &HttpServer::accept);
+        listen(QHostAddress::LocalHost);
+    }
+
+    QUrl url(const QString &path) const
+    {
+        return QUrl(QLatin1String("http://127.0.0.1:") + QString::number(serverPort()) + path);
+    }
+
+    QByteArray body(const QByteArray &path) const
+    {
+        return QByteArray("image data for ") + path + QByteArray(1024, 'x');
+    }
+
+    int requests = 0;
+    int notModified = 0;
+    QByteArray lastIfNoneMatch;
+
+private:
+    void accept()
+    {
+        while (QTcpSocket *socket = nextPendingConnection()) {
+            connect(socket, &QTcpSocket::readyRead, this, [this, socket] {
+                m_buffers[socket] += socket->readAll();
+                if (m_buffers[socket].contains("\r\n\r\n")) {
+                    reply(socket, m_buffers.take(socket));
+                }
+            });
+            connect(socket, &QTcpSocket::disconnected, socket, &QObject::deleteLater);
+        }
+    }
+
+    void reply(QTcpSocket *socket, const QByteArray &request)
+    {
+        ++requests;
+        const QList<QByteArray> lines = request.split('\n');
+        const QByteArray path = lines.first().split(' ').value(1);
+        const QByteArray etag = '"' + QByteArray::number(qHash(path)) + '"';
+
+        lastIfNoneMatch.clear();
+        for (const QByteArray &line : lines) {
+            if (line.toLower().startsWith("if-none-match:")) {
+                lastIfNoneMatch = line.mid(line.indexOf(':') + 1).trimmed();
+            }
+        }
+
+        QByteArray response;
+        if (lastIfNoneMatch == etag) {
+            ++notModified;
+            response = "HTTP/1.1 304 Not Modified\r\nETag: " + etag + "\r\nConnection: close\r\n\r\n";
+        } else {
+            const QByteArray data = body(path);
+            response = "HTTP/1.1 200 OK\r\nContent-Type: image/png\r\nETag: " + etag +
+                       "\r\nContent-Length: " + QByteArray::number(data.size()) +
+                       "\r\nConnection: close\r\n\r\n" + data;
+        }
+        socket->write(response);
+        socket->disconnectFromHost();
+    }
+
+    QHash<QTcpSocket*, QByteArray> m_buffers;
+};
+
+class ScreenshotCacheTest : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void init();
+    void storeAndHit();
+    void revalidate();
+    void evictLeastRecentlyUsed();
+
+private:
+    QString fetch(ScreenshotCache &cache, const QUrl &url);
+
+    QScopedPointer<QTemporaryDir> m_dir;
+    QScopedPointer<HttpServer> m_server;
+};
+
+void ScreenshotCacheTest::init()
+{
+    m_dir.reset(new QTemporaryDir);
+    QVERIFY(m_dir->isValid());
+    m_server.reset(new HttpServer);
+    QVERIFY(m_server->isListening());
+}
+
+QString ScreenshotCacheTest::fetch(ScreenshotCache &cache, const QUrl &url)
+{
+    QSignalSpy spy(&cache, &ScreenshotCache::ready);
+    cache.fetch(url);
+    if (spy.isEmpty() && !spy.wait(10000)) {
+        return QString();
+    }
+    return spy.first().at(1).toString();
+}
+
+void ScreenshotCacheTest::storeAndHit()
+{
+    const QUrl url = m_server->url(QLatin1String("/thumb.png"));
+    {
+        ScreenshotCache cache(m_dir->path(), 1024 * 1024);
+        QVERIFY(cache.fileName(url).isEmpty());
+
+        const QString fileName = fetch(cache, url);
+        QVERIFY(!fileName.isEmpty());
+        QCOMPARE(m_server->requests, 1);
+
+        QFile file(fileName);
+        QVERIFY(file.open(QIODevice::ReadOnly));
+        QCOMPARE(file.readAll(), m_server->body("/thumb.png"));
+
+        // A fresh entry is answered from disk at once
+        QSignalSpy spy(&cache, &ScreenshotCache::ready);
+        cache.fetch(url);
+        QCOMPARE(spy.count(), 1);
+        QCOMPARE(spy.first().at(1).toString(), fileName);
+        QVERIFY(!cache.isFetching(url));
+        QCOMPARE(m_server->requests, 1);
+    }
+
+    // The index survives the instance
+    ScreenshotCache cache(m_dir->path(), 1024 * 1024);
+    QVERIFY(!cache.fileName(url).isEmpty());
+    QCOMPARE(cache.size(), qint64(m_server->body("/thumb.png").size()));
+}
+
+void ScreenshotCacheTest::revalidate()
+{
+    const QUrl url = m_server->url(QLatin1String("/screenshot.png"));
+    ScreenshotCache cache(m_dir->path(), 1024 * 1024);
+    const QString fileName = fetch(cache, url);
+    QVERIFY(!fileName.isEmpty());
+    const QByteArray etag = '"' + QByteArray::number(qHash(QByteArray("/screenshot.png"))) + '"';
+
+    // Stale, the copy on disk is handed out and checked with the server
+    cache.setMaxAge(0);
+    QSignalSpy spy(&cache, &ScreenshotCache::ready);
+    cache.fetch(url);
+    QCOMPARE(spy.count(), 1);
+    QCOMPARE(spy.first().at(1).toString(), fileName);
+    QVERIFY(cache.isFetching(url));
+
+    QTRY_VERIFY_WITH_TIMEOUT(!cache.isFetching(url), 10000);
+    QCOMPARE(m_server->requests, 2);
+    QCOMPARE(m_server->lastIfNoneMatch, etag);
+    QCOMPARE(m_server->notModified, 1);
+
+    // Not modified keeps the file and doesn't announce it again
+    QCOMPARE(spy.count(), 1);
+    QCOMPARE(cache.fileName(url), fileName);
+    QFile file(fileName);
+    QVERIFY(file.open(QIODevice::ReadOnly));
+    QCOMPARE(file.readAll(), m_server->body("/screenshot.png"));
+
+    // Now validated, it is fresh again
+    cache.setMaxAge(60 * 60 * 1000);
+    cache.fetch(url);
+    QVERIFY(!cache.isFetching(url));
+    QCOMPARE(m_server->requests, 2);
+}
+
+void ScreenshotCacheTest::evictLeastRecentlyUsed()
+{
+    const QUrl a = m_server->url(QLatin1String("/a.png"));
+    const QUrl b = m_server->url(QLatin1String("/b.png"));
+    const QUrl c = m_server->url(QLatin1String("/c.png"));
+    const qint64 entrySize = m_server->body("/a.png").size();
+
+    // Room for two entries
+    ScreenshotCache cache(m_dir->path(), entrySize * 2 + entrySize / 2);
+    const QString fileA = fetch(cache, a);
+    QTest::qWait(5);
+    const QString fileB = fetch(cache, b);
+    QTest::qWait(5);
+    QVERIFY(!fileA.isEmpty());
+    QVERIFY(!fileB.isEmpty());
+
+    // Using a makes b the least recently used
+    QCOMPARE(cache.fileName(a), fileA);
+    QTest::qWait(5);
+
+    const QString fileC = fetch(cache, c);
+    QVERIFY(!fileC.isEmpty());
+    QVERIFY(cache.size() <= entrySize * 2 + entrySize / 2);
+    QCOMPARE(cache.fileName(a), fileA);
+    QCOMPARE(cache.fileName(c), fileC);
+    QVERIFY(cache.fileName(b).isEmpty());
+    QVERIFY(!QFile::exists(fileB));
+    QVERIFY(QFile::exists(fileA));
+}
+
+QTEST_MAIN(ScreenshotCacheTest)
+
+#include "ScreenshotCacheTest.moc"
@@ -21,8 +21,8 @@
 
 #include <config.h>
 
-#include <optional>
 #include <AppStreamQt5/pool.h>
+#include <AppStreamQt5/component.h>
 #include <AppStreamQt5/icon.h>
 #include <AppStreamQt5/image.h>
 #include <AppStreamQt5/screenshot.h>
@@ -31,9 +31,24 @@
 
 #include <QApplication>
 #include <QLoggingCategory>
+#include <QtConcurrentRun>
 
 Q_DECLARE_LOGGING_CATEGORY(APPER_LIB)
 
+#ifdef HAVE_APPSTREAM
+// Ordered by size and then by URL, so the thumbnail picked
+// doesn't depend on the order the catalog lists them in
+static bool isSmaller(const AppStream::Image &image, const AppStream::Image &other)
+{
+    const qint64 area = qint64(image.size().width()) * image.size().height();
+    const qint64 otherArea = qint64(other.size().width()) * other.size().height();
+    if (area != otherArea) {
+        return area < otherArea;
+    }
+    return image.url().toString() < other.url().toString();
+}
+#endif //HAVE_APPSTREAM
+
 AppStreamHelper* AppStreamHelper::m_instance = 0;
 
 AppStreamHelper* AppStreamHelper::instance()
@@ -49,208 +64,207 @@ AppStreamHelper* AppStreamHelper::instance()
 AppStreamHelper::AppStreamHelper(QObject *parent)
  : QObject(parent)
 {
-#ifdef HAVE_APPSTREAM
-    // create new AppStream metadata pool
-    m_pool = new AppStream::Pool(this);
-#endif //HAVE_APPSTREAM
+    m_watcher = new QFutureWatcher<LoadResult>(this);
+    connect(m_watcher, &QFutureWatcher<LoadResult>::finished, this, &AppStreamHelper::loadFinished);
 }
 
 AppStreamHelper::~AppStreamHelper()
 {
+    // Don't leave the worker writing the cache behind
+    m_watcher->waitForFinished();
 }
 
-bool AppStreamHelper::open()
+bool AppStreamHelper::isReady() const
 {
-#ifdef HAVE_APPSTREAM    
-    QString error;
-    if (!m_pool->load()) {
-        qCWarning(APPER_LIB) << "Unable to open AppStream metadata pool:" << m_pool->lastError();
-        return false;
-    }
-
-//    // cache application data (we should actually search the data directly via as_pool_search()...)
-//    auto cptArray = as_pool_get_components(m_pool);
-//    if (cptArray == NULL) {
-//        qWarning("AppStream application array way NULL! (This should never happen)");
-//        return false;
-//    }
-
-//    for (uint i = 0; i < cptArray->len; i++) {
-//        auto cpt = AS_COMPONENT (g_ptr_array_index(cptArray, i));
-//        // we only want apps at time
-//        auto cptKind = as_component_get_kind (cpt);
-//        if ((cptKind != AS_COMPONENT_KIND_DESKTOP_APP) &&
-//            (cptKind != AS_COMPONENT_KIND_CONSOLE_APP) &&
-//            (cptKind != AS_COMPONENT_KIND_WEB_APP))
-//            continue;
-
-//        Application app;
-//        // Application name
-//        app.name = QString::fromUtf8(as_component_get_name(cpt));
-
-//        // Package name
-//        auto pkgnameC = as_component_get_pkgname(cpt);
-//        QString pkgName;
-//        if (pkgnameC != NULL)
-//            pkgName = QString::fromUtf8(pkgnameC);
-
-//        // Desktop file
-//        app.id = QString::fromUtf8(as_component_get_id(cpt));
-
-//        // Summary
-//        app.summary = QString::fromUtf8(as_component_get_summary(cpt));
-
-//        // Description
-//        app.description = QString::fromUtf8(as_component_get_description(cpt));
-
-//        // Application stock icon
-//        auto icons = as_component_get_icons(cpt);
-//        for (uint i = 0; i < icons->len; i++) {
-//            auto icon = AS_ICON (g_ptr_array_index (icons, i));
-//            if (as_icon_get_kind (icon) != AS_ICON_KIND_STOCK)
-//                 app.icon_url = QString::fromUtf8(as_icon_get_filename (icon));
-//        }
-
-//        // Application categories
-//        app.categories = QStringList();
-//        auto cats = as_component_get_categories(cpt);
-//        for (uint i = 0; i < cats->len; i++) {
-//            auto category = (const gchar*) g_ptr_array_index (cats, i);
-//            app.categories << QString::fromUtf8(category);
-//        }
-
-//        // add default screenshot urls
-//        auto scrs = as_component_get_screenshots (cpt);
-
-//        // find default screenshot, if possible (otherwise we get a random one)
-//        AsScreenshot *scr = NULL;
-//        for (uint i = 0; i < scrs->len; i++) {
-//            scr = AS_SCREENSHOT (g_ptr_array_index (scrs, i));
-//            if (as_screenshot_get_kind (scr) == AS_SCREENSHOT_KIND_DEFAULT)
-//                break;
-//        }
-
-//        if (scr != NULL) {
-//            auto imgs = as_screenshot_get_images (scr);
-//            for (uint i = 0; i < imgs->len; i++) {
-//                auto img = AS_IMAGE (g_ptr_array_index (imgs, i));
-//                if ((as_image_get_kind (img) == AS_IMAGE_KIND_SOURCE) && (app.screenshot.isEmpty())) {
-//                    app.screenshot = QString::fromUtf8(as_image_get_url (img));
-//                } else if ((as_image_get_kind (img) == AS_IMAGE_KIND_THUMBNAIL) && (app.thumbnail.isEmpty())) {
-//                    app.thumbnail = QString::fromUtf8(as_image_get_url (img));
-//                }
-
-//                if ((!app.screenshot.isEmpty()) && (!app.thumbnail.isEmpty()))
-//                    break;
-//            }
-//        }
-
-//        m_appInfo.insertMulti(pkgName, app);
-//    }
-
-    auto apps = m_pool->componentsByKind(AppStream::Component::KindDesktopApp);
-    for (const AppStream::Component &app : apps) {
-        const QStringList pkgNames = app.packageNames();
-        for (const QString &pkgName : pkgNames) {
-            m_appInfo.insertMulti(pkgName, app);
-        }
-    }
+    return m_ready;
+}
 
-    return true;
-#else
-    return false;
-#endif
+QFuture<void> AppStreamHelper::loadFuture() const
+{
+    return m_watcher->future();
 }
 
-QList<AppStream::Component> AppStreamHelper::applications(const QString &pkgName) const
+void AppStreamHelper::open()
 {
-    return m_appInfo.values(pkgName);
+    // Loading the pool takes seconds with big catalogs, and even
+    // checking the cache touches the disk, so it must not happen
+    // on the GUI thread
+    m_watcher->setFuture(QtConcurrent::run(&AppStreamHelper::loadCache));
 }
 
-QString AppStreamHelper::genericIcon(const QString &pkgName) const
+void AppStreamHelper::loadFinished()
 {
-    if (m_appInfo.contains(pkgName)) {
-//        const QList<AppStream::Component> apps = applications(pkgName);
-//        for (const AppStream::Component &app : apps) {
-//            if (!app.icon_url.isEmpty()) {
-//                return app.icon_url;
-//            }
-//        }
-    }
+    const LoadResult result = m_watcher->result();
+    m_cache = result.cache;
+    m_media = result.media;
+    m_ready = true;
+    qCDebug(APPER_LIB) << "AppStream data loaded with" << m_cache->count() << "applications";
 
-    return QString();
+    emit ready();
 }
 
-QStringList AppStreamHelper::findPkgNames(const CategoryMatcher &/*parser*/) const
+AppStreamHelper::LoadResult AppStreamHelper::loadCache()
 {
-    QStringList packages;
+    LoadResult result;
+    result.cache.reset(new AppStreamCache);
+    const QString fileName = AppStreamCache::defaultFileName();
+    const quint64 key = AppStreamCache::catalogKey();
+    if (!result.cache->open(fileName, key)) {
+        // The catalogs changed or this is the first run, extract what we
+        // need from the pool and share it with the other Apper processes
+        const AppStreamCache::Entries entries = loadPool();
+        if (!AppStreamCache::write(fileName, key, entries) ||
+                !result.cache->open(fileName, key)) {
+            // Without a usable cache file keep what we extracted in memory
+            qCWarning(APPER_LIB) << "AppStream cache unavailable, using the data in memory";
+            result.cache->setEntries(entries);
+        }
+    }
 
-//    QHash<QString, Application>::const_iterator i = m_appInfo.constBegin();
-//    while (i != m_appInfo.constEnd()) {
-//        if (parser.match(i.value().categories)) {
-////            kDebug() << i.key() << categories;
-//            packages << i.key();
-//        }
-//        ++i;
-//    }
+    // Resolve the media of every package now, so showing the details
+    // of a package doesn't need to decode its applications
+    const AppStreamCache *cache = result.cache.data();
+    for (int i = 0; i < cache->count(); ++i) {
+        const QUrl thumbnail = cache->thumbnail(i);
+        const QUrl screenshot = cache->screenshot(i);
+        if (thumbnail.isEmpty() && screenshot.isEmpty()) {
+            continue;
+        }
 
-    return packages;
+        Media &media = result.media[cache->packageName(i)];
+        if (media.thumbnail.isEmpty()) {
+            media.thumbnail = thumbnail;
+        }
+        if (media.screenshot.isEmpty()) {
+            media.screenshot = screenshot;
+        }
+    }
+
+    return result;
 }
 
-QUrl AppStreamHelper::thumbnail(const QString &pkgName) const
+AppStreamCache::Entries AppStreamHelper::loadPool()
 {
-    QUrl url;
+    AppStreamCache::Entries entries;
 #ifdef HAVE_APPSTREAM
-    if (m_appInfo.contains(pkgName)) {
-        AppStream::Image thumb;
-        AppStream::Component cpt = m_appInfo.value(pkgName);
+    // The pool lives only while we extract data from it
+    AppStream::Pool pool;
+    if (!pool.load()) {
+        qCWarning(APPER_LIB) << "Unable to open AppStream metadata pool:" << pool.lastError();
+        return entries;
+    }
+
+    const QList<AppStream::Component> apps = pool.componentsByKind(AppStream::Component::KindDesktopApp);
+    for (const AppStream::Component &cpt : apps) {
+        Application app;
+        app.id = cpt.id();
+        app.name = cpt.name();
+        app.summary = cpt.summary();
+        app.description = cpt.description();
+        app.categories = cpt.categories();
+
+        // Application stock icon
+        const QList<AppStream::Icon> icons = cpt.icons();
+        for (const AppStream::Icon &icon : icons) {
+            if (icon.url().isEmpty()) {
+                app.icon = icon.name();
+            } else {
+                app.icon = icon.url().toLocalFile();
+            }
+            break;
+        }
+
+        // Smallest thumbnail and the source image of the default
+        // screenshot, or of the first one if there is no default
         const QList<AppStream::Screenshot> screenshots = cpt.screenshotsAll();
         for (const AppStream::Screenshot &screenshot : screenshots) {
             const QList<AppStream::Image> images = screenshot.images();
-            for (const AppStream::Image &image : images) {
-                if (image.kind() == AppStream::Image::KindThumbnail) {
-                    if (thumb.kind() == AppStream::Image::KindUnknown || image.size().height() < thumb.size().height()) {
+            if (images.isEmpty()) {
+                continue;
+            }
+
+            if (app.screenshot.isEmpty() || screenshot.isDefault()) {
+                AppStream::Image thumb;
+                AppStream::Image source;
+                for (const AppStream::Image &image : images) {
+                    if (image.kind() == AppStream::Image::KindSource) {
+                        if (source.url().isEmpty()) {
+                            source = image;
+                        }
+                    } else if (image.kind() == AppStream::Image::KindThumbnail &&
+                               (thumb.url().isEmpty() || isSmaller(image, thumb))) {
                         thumb = image;
-                        url = image.url();
                     }
                 }
+                app.thumbnail = thumb.url();
+                // Catalogs without a source image still have a usable one
+                app.screenshot = source.url().isEmpty() ? images.first().url() : source.url();
             }
 
-            if (screenshot.isDefault() && !url.isEmpty()) {
+            if (screenshot.isDefault()) {
                 break;
             }
         }
-    }
 
-    return url;
-#else
-    Q_UNUSED(pkgName)
-    return url;
+        const QStringList pkgNames = cpt.packageNames();
+        for (const QString &pkgName : pkgNames) {
+            entries << qMakePair(pkgName, app);
+        }
+    }
 #endif //HAVE_APPSTREAM
+    return entries;
 }
 
-QUrl AppStreamHelper::screenshot(const QString &pkgName) const
+QList<AppStreamHelper::Application> AppStreamHelper::applications(const QString &pkgName) const
 {
-    QUrl url;
-#ifdef HAVE_APPSTREAM
-    if (m_appInfo.contains(pkgName)) {
-        AppStream::Component cpt = m_appInfo.value(pkgName);
-        const QList<AppStream::Screenshot> screenshots = cpt.screenshotsAll();
-        for (const AppStream::Screenshot &screenshot : screenshots) {
-            const QList<AppStream::Image> images = screenshot.images();
-            for (const AppStream::Image &image : images) {
-                url = image.url();
-                break;
-            }
+    if (!m_cache) {
+        return QList<Application>();
+    }
+    return m_cache->applications(pkgName);
+}
 
-            if (screenshot.isDefault() && !url.isEmpty()) {
-                break;
-            }
+QString AppStreamHelper::genericIcon(const QString &pkgName) const
+{
+    const QList<Application> apps = applications(pkgName);
+    for (const Application &app : apps) {
+        if (!app.icon.isEmpty()) {
+            return app.icon;
         }
     }
 
-#else
-    Q_UNUSED(pkgName)
-#endif //HAVE_APPSTREAM
-    return url;
+    return QString();
+}
+
+QStringList AppStreamHelper::findPkgNames(const CategoryMatcher &parser) const
+{
+    QStringList packages;
+    if (!m_cache) {
+        return packages;
+    }
+
+    for (int i = 0; i < m_cache->count(); ++i) {
+        if (parser.match(m_cache->application(i).categories)) {
+            packages << m_cache->packageName(i);
+        }
+    }
+    packages.removeDuplicates();
+
+    return packages;
 }
+
+QUrl AppStreamHelper::thumbnail(const QString &pkgName) const
+{
+    return m_media.value(pkgName).thumbnail;
+}
+
+QUrl AppStreamHelper::screenshot(const QString &pkgName) const
+{
+    return m_media.value(pkgName).screenshot;
+}
+
+AppStreamHelper::Media AppStreamHelper::media(const QString &pkgName) const
+{
+    return m_media.value(pkgName);
+}
+
+#include "moc_AppStream.cpp"
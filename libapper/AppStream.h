@@ -23,36 +23,69 @@
 #define APPSTREAM_H
 
 #include "CategoryMatcher.h"
-
-#include <AppStreamQt5/component.h>
+#include "AppStreamCache.h"
 
 #include <QObject>
 #include <QHash>
-
-namespace AppStream {
-class Pool;
-}
-
-struct _AsScreenshotService;
-typedef struct _AsScreenshotService AsScreenshotService;
+#include <QSharedPointer>
+#include <QFuture>
+#include <QFutureWatcher>
 
 class Q_DECL_EXPORT AppStreamHelper : public QObject {
+    Q_OBJECT
     public:
+        typedef AppStreamCache::Application Application;
+        struct Media {
+            QUrl thumbnail;
+            QUrl screenshot;
+        };
+
+        /**
+         * Returns the helper, the first call starts loading
+         * the AppStream data on a worker thread
+         */
         static AppStreamHelper* instance();
         virtual ~AppStreamHelper();
-        bool open();
 
-        QList<AppStream::Component> applications(const QString &pkgName) const;
+        /**
+         * True once the data finished loading, before that all
+         * lookups return empty results
+         */
+        bool isReady() const;
+        QFuture<void> loadFuture() const;
+
+        QList<Application> applications(const QString &pkgName) const;
         QString genericIcon(const QString &pkgName) const;
         QStringList findPkgNames(const CategoryMatcher &parser) const;
         QUrl thumbnail(const QString &pkgName) const;
         QUrl screenshot(const QString &pkgName) const;
+        /**
+         * Best thumbnail and screenshot of the package, resolved
+         * once when the data is loaded
+         */
+        Media media(const QString &pkgName) const;
+
+    Q_SIGNALS:
+        void ready();
+
+    private Q_SLOTS:
+        void loadFinished();
 
     private:
         explicit AppStreamHelper(QObject *parent = 0);
-        AppStream::Pool *m_pool;
+        void open();
+        struct LoadResult {
+            QSharedPointer<AppStreamCache> cache;
+            QHash<QString, Media> media;
+        };
+        static LoadResult loadCache();
+        static AppStreamCache::Entries loadPool();
+
+        QFutureWatcher<LoadResult> *m_watcher;
+        QSharedPointer<AppStreamCache> m_cache;
+        QHash<QString, Media> m_media;
+        bool m_ready = false;
 
-        QHash<QString, AppStream::Component> m_appInfo;
         static AppStreamHelper         *m_instance;
 };
 
@@ -0,0 +1,418 @@
+/***************************************************************************
+ *   Copyright (C) 2026 by agent                                           *
+ *   agent@local                                                           *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; see the file COPYING. If not, write to       *
+ *   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,  *
+ *   Boston, MA 02110-1301, USA.                                           *
+ ***************************************************************************/
+
+#include "AppStreamCache.h"
+
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QLocale>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QLoggingCategory>
+
+#include <algorithm>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define CACHE_MAGIC   "APPERASC"
+#define CACHE_VERSION 1
+
+Q_DECLARE_LOGGING_CATEGORY(APPER_LIB)
+
+namespace {
+
+struct Header {
+    char    magic[8];
+    quint32 version;
+    quint32 recordCount;
+    quint64 catalogKey;
+    quint32 recordsOffset;
+    quint32 stringsOffset;
+    quint32 stringsSize;
+    quint32 reserved;
+};
+
+// Every field is an offset in the string pool
+struct Record {
+    quint32 pkgName;
+    quint32 id;
+    quint32 name;
+    quint32 summary;
+    quint32 description;
+    quint32 icon;
+    quint32 categories;
+    quint32 thumbnail;
+    quint32 screenshot;
+};
+
+// Places where AppStream looks for catalog data, any change
+// to them means the pool would load something different
+const char *const catalogPaths[] = {
+    "/usr/share/swcatalog/xml",
+    "/usr/share/swcatalog/yaml",
+    "/usr/share/app-info/xmls",
+    "/usr/share/app-info/yaml",
+    "/var/lib/app-info/xmls",
+    "/var/lib/app-info/yaml",
+    "/var/cache/app-info/xmls",
+    "/var/cache/app-info/yaml",
+    "/usr/share/metainfo",
+    "/usr/share/appdata"
+};
+
+class StringPool
+{
+public:
+    StringPool()
+    {
+        // offset 0 is always the empty string
+        add(QByteArray());
+    }
+
+    quint32 add(const QByteArray &string)
+    {
+        auto it = m_offsets.constFind(string);
+        if (it != m_offsets.constEnd()) {
+            return it.value();
+        }
+
+        const quint32 offset = m_data.size();
+        const quint32 length = string.size();
+        m_data.append(reinterpret_cast<const char*>(&length), sizeof(length));
+        m_data.append(string);
+        m_offsets.insert(string, offset);
+        return offset;
+    }
+
+    quint32 add(const QString &string)
+    {
+        return add(string.toUtf8());
+    }
+
+    QByteArray data() const
+    {
+        return m_data;
+    }
+
+private:
+    QByteArray m_data;
+    QHash<QByteArray, quint32> m_offsets;
+};
+
+}
+
+AppStreamCache::AppStreamCache()
+{
+}
+
+AppStreamCache::~AppStreamCache()
+{
+    close();
+}
+
+bool AppStreamCache::open(const QString &fileName, quint64 catalogKey)
+{
+    close();
+
+    int fd = ::open(QFile::encodeName(fileName).constData(), O_RDONLY | O_CLOEXEC);
+    if (fd == -1) {
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) == -1 || st.st_size < static_cast<off_t>(sizeof(Header))) {
+        ::close(fd);
+        return false;
+    }
+
+    // The mapping stays valid after the descriptor is closed, and
+    // since writers replace the file atomically it is never
+    // truncated under our feet
+    void *data = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (data == MAP_FAILED) {
+        qCWarning(APPER_LIB) << "Failed to map AppStream cache" << fileName;
+        return false;
+    }
+    m_data = static_cast<const uchar*>(data);
+    m_size = st.st_size;
+
+    if (!attach(catalogKey)) {
+        qCDebug(APPER_LIB) << "AppStream cache is outdated" << fileName;
+        close();
+        return false;
+    }
+    return true;
+}
+
+void AppStreamCache::setEntries(Entries entries)
+{
+    close();
+
+    // Same layout as the file, only kept in memory
+    m_buffer = build(0, entries);
+    m_data = reinterpret_cast<const uchar*>(m_buffer.constData());
+    m_size = m_buffer.size();
+    attach(0);
+}
+
+void AppStreamCache::close()
+{
+    if (m_data && m_buffer.isNull()) {
+        munmap(const_cast<uchar*>(m_data), m_size);
+    }
+    m_buffer.clear();
+    m_data = nullptr;
+    m_size = 0;
+    m_count = 0;
+}
+
+bool AppStreamCache::attach(quint64 catalogKey)
+{
+    Header header;
+    memcpy(&header, m_data, sizeof(Header));
+    const qint64 recordsEnd = qint64(header.recordsOffset) + qint64(header.recordCount) * sizeof(Record);
+    if (memcmp(header.magic, CACHE_MAGIC, sizeof(header.magic)) != 0 ||
+            header.version != CACHE_VERSION ||
+            header.catalogKey != catalogKey ||
+            header.recordsOffset != sizeof(Header) ||
+            recordsEnd > header.stringsOffset ||
+            qint64(header.stringsOffset) + header.stringsSize > m_size) {
+        return false;
+    }
+
+    m_count = header.recordCount;
+    m_stringsOffset = header.stringsOffset;
+    m_stringsSize = header.stringsSize;
+    return true;
+}
+
+bool AppStreamCache::isOpen() const
+{
+    return m_data;
+}
+
+QList<AppStreamCache::Application> AppStreamCache::applications(const QString &pkgName) const
+{
+    QList<Application> ret;
+    const QByteArray key = pkgName.toUtf8();
+    for (int i = lowerBound(key); i < static_cast<int>(m_count); ++i) {
+        Record record;
+        memcpy(&record, m_data + sizeof(Header) + i * sizeof(Record), sizeof(Record));
+        if (rawString(record.pkgName) != key) {
+            break;
+        }
+        ret << application(i);
+    }
+    return ret;
+}
+
+bool AppStreamCache::contains(const QString &pkgName) const
+{
+    const QByteArray key = pkgName.toUtf8();
+    const int i = lowerBound(key);
+    return i < static_cast<int>(m_count) && packageName(i).toUtf8() == key;
+}
+
+int AppStreamCache::count() const
+{
+    return m_count;
+}
+
+QString AppStreamCache::packageName(int record) const
+{
+    Record rec;
+    memcpy(&rec, m_data + sizeof(Header) + record * sizeof(Record), sizeof(Record));
+    return string(rec.pkgName);
+}
+
+AppStreamCache::Application AppStreamCache::application(int record) const
+{
+    Record rec;
+    memcpy(&rec, m_data + sizeof(Header) + record * sizeof(Record), sizeof(Record));
+
+    Application app;
+    app.id = string(rec.id);
+    app.name = string(rec.name);
+    app.summary = string(rec.summary);
+    app.description = string(rec.description);
+    app.icon = string(rec.icon);
+    app.categories = string(rec.categories).split(QLatin1Char(';'), QString::SkipEmptyParts);
+    app.thumbnail = QUrl(string(rec.thumbnail));
+    app.screenshot = QUrl(string(rec.screenshot));
+    return app;
+}
+
+QUrl AppStreamCache::thumbnail(int record) const
+{
+    Record rec;
+    memcpy(&rec, m_data + sizeof(Header) + record * sizeof(Record), sizeof(Record));
+    return QUrl(string(rec.thumbnail));
+}
+
+QUrl AppStreamCache::screenshot(int record) const
+{
+    Record rec;
+    memcpy(&rec, m_data + sizeof(Header) + record * sizeof(Record), sizeof(Record));
+    return QUrl(string(rec.screenshot));
+}
+
+bool AppStreamCache::write(const QString &fileName, quint64 catalogKey, const Entries &entries)
+{
+    const QByteArray data = build(catalogKey, entries);
+
+    QDir().mkpath(QFileInfo(fileName).absolutePath());
+
+    // QSaveFile renames on commit so processes that have
+    // the old file mapped keep reading consistent data
+    QSaveFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qCWarning(APPER_LIB) << "Failed to write AppStream cache" << fileName << file.errorString();
+        return false;
+    }
+    file.write(data);
+    return file.commit();
+}
+
+QByteArray AppStreamCache::build(quint64 catalogKey, Entries entries)
+{
+    std::stable_sort(entries.begin(), entries.end(), [] (const QPair<QString, Application> &a, const QPair<QString, Application> &b) {
+        return a.first.toUtf8() < b.first.toUtf8();
+    });
+
+    StringPool strings;
+    QVector<Record> records;
+    records.reserve(entries.size());
+    for (const auto &entry : qAsConst(entries)) {
+        const Application &app = entry.second;
+        Record record;
+        record.pkgName = strings.add(entry.first);
+        record.id = strings.add(app.id);
+        record.name = strings.add(app.name);
+        record.summary = strings.add(app.summary);
+        record.description = strings.add(app.description);
+        record.icon = strings.add(app.icon);
+        record.categories = strings.add(app.categories.join(QLatin1Char(';')));
+        record.thumbnail = strings.add(app.thumbnail.toString());
+        record.screenshot = strings.add(app.screenshot.toString());
+        records << record;
+    }
+    const QByteArray pool = strings.data();
+
+    Header header;
+    memcpy(header.magic, CACHE_MAGIC, sizeof(header.magic));
+    header.version = CACHE_VERSION;
+    header.recordCount = records.size();
+    header.catalogKey = catalogKey;
+    header.recordsOffset = sizeof(Header);
+    header.stringsOffset = sizeof(Header) + records.size() * sizeof(Record);
+    header.stringsSize = pool.size();
+    header.reserved = 0;
+
+    QByteArray data;
+    data.reserve(header.stringsOffset + pool.size());
+    data.append(reinterpret_cast<const char*>(&header), sizeof(Header));
+    data.append(reinterpret_cast<const char*>(records.constData()), records.size() * sizeof(Record));
+    data.append(pool);
+    return data;
+}
+
+QString AppStreamCache::defaultFileName()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation) + QLatin1String("/apper/appstream.cache");
+}
+
+quint64 AppStreamCache::catalogKey()
+{
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    for (const char *path : catalogPaths) {
+        const QFileInfo dirInfo(QLatin1String(path));
+        if (!dirInfo.isDir()) {
+            continue;
+        }
+
+        hash.addData(path);
+        hash.addData(QByteArray::number(dirInfo.lastModified().toMSecsSinceEpoch()));
+
+        // Files updated in place don't change the directory mtime
+        const QFileInfoList files = QDir(dirInfo.filePath()).entryInfoList(QDir::Files | QDir::NoDotAndDotDot, QDir::Name);
+        for (const QFileInfo &file : files) {
+            hash.addData(QFile::encodeName(file.fileName()));
+            hash.addData(QByteArray::number(file.lastModified().toMSecsSinceEpoch()));
+            hash.addData(QByteArray::number(file.size()));
+        }
+    }
+
+    // Names, summaries and descriptions are stored translated
+    hash.addData(QLocale().name().toLatin1());
+
+    quint64 key;
+    memcpy(&key, hash.result().constData(), sizeof(key));
+    return key;
+}
+
+int AppStreamCache::lowerBound(const QByteArray &pkgName) const
+{
+    int first = 0;
+    int count = m_count;
+    while (count > 0) {
+        const int step = count / 2;
+        const int middle = first + step;
+        Record record;
+        memcpy(&record, m_data + sizeof(Header) + middle * sizeof(Record), sizeof(Record));
+        if (rawString(record.pkgName) < pkgName) {
+            first = middle + 1;
+            count -= step + 1;
+        } else {
+            count = step;
+        }
+    }
+    return first;
+}
+
+QByteArray AppStreamCache::rawString(quint32 offset) const
+{
+    if (qint64(offset) + sizeof(quint32) > m_stringsSize) {
+        return QByteArray();
+    }
+
+    quint32 length;
+    memcpy(&length, m_data + m_stringsOffset + offset, sizeof(length));
+    if (qint64(offset) + sizeof(quint32) + length > m_stringsSize) {
+        return QByteArray();
+    }
+
+    // Doesn't copy, the mapping outlives the returned array
+    return QByteArray::fromRawData(reinterpret_cast<const char*>(m_data + m_stringsOffset + offset + sizeof(quint32)), length);
+}
+
+QString AppStreamCache::string(quint32 offset) const
+{
+    const QByteArray raw = rawString(offset);
+    return QString::fromUtf8(raw.constData(), raw.size());
+}
@@ -0,0 +1,116 @@
+/***************************************************************************
+ *   Copyright (C) 2026 by agent                                           *
+ *   agent@local                                                           *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; see the file COPYING. If not, write to       *
+ *   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,  *
+ *   Boston, MA 02110-1301, USA.                                           *
+ ***************************************************************************/
+
+#ifndef APPSTREAM_CACHE_H
+#define APPSTREAM_CACHE_H
+
+#include <QByteArray>
+#include <QString>
+#include <QStringList>
+#include <QUrl>
+#include <QVector>
+#include <QPair>
+
+/**
+ * Flat, memory mapped, cache of the few AppStream fields Apper uses.
+ *
+ * Loading the AppStream pool keeps the whole library object graph
+ * alive, this file is written once per catalog change and then shared
+ * by every process linking libapper, so a warm start only needs to
+ * map it.
+ *
+ * Layout (native endianness, the file never leaves the machine):
+ *   Header
+ *   Record[recordCount]  sorted by package name
+ *   string pool          quint32 length followed by UTF-8 bytes
+ */
+class Q_DECL_EXPORT AppStreamCache
+{
+public:
+    struct Application {
+        QString     id;
+        QString     name;
+        QString     summary;
+        QString     description;
+        QString     icon;
+        QStringList categories;
+        QUrl        thumbnail;
+        QUrl        screenshot;
+    };
+    typedef QVector<QPair<QString, Application> > Entries;
+
+    AppStreamCache();
+    ~AppStreamCache();
+
+    /**
+     * Maps the cache file, returns false if the file is missing,
+     * was written by another version or for other catalogs
+     */
+    bool open(const QString &fileName, quint64 catalogKey);
+    /**
+     * Serves the entries from memory, for when the cache
+     * file can't be written
+     */
+    void setEntries(Entries entries);
+    bool isOpen() const;
+
+    QList<Application> applications(const QString &pkgName) const;
+    bool contains(const QString &pkgName) const;
+    int count() const;
+    QString packageName(int record) const;
+    Application application(int record) const;
+    QUrl thumbnail(int record) const;
+    QUrl screenshot(int record) const;
+
+    /**
+     * Writes the entries (package name, application) to fileName
+     */
+    static bool write(const QString &fileName, quint64 catalogKey, const Entries &entries);
+
+    /**
+     * Default location of the cache, shared by all Apper components
+     */
+    static QString defaultFileName();
+
+    /**
+     * Key built from the modification times of the AppStream
+     * catalogs and the locale the texts are translated to
+     */
+    static quint64 catalogKey();
+
+private:
+    Q_DISABLE_COPY(AppStreamCache)
+    static QByteArray build(quint64 catalogKey, Entries entries);
+    void close();
+    bool attach(quint64 catalogKey);
+    int lowerBound(const QByteArray &pkgName) const;
+    QByteArray rawString(quint32 offset) const;
+    QString string(quint32 offset) const;
+
+    // Owns the data when it is not mapped from the file
+    QByteArray m_buffer;
+    const uchar *m_data = nullptr;
+    qint64 m_size = 0;
+    quint32 m_count = 0;
+    quint32 m_stringsOffset = 0;
+    quint32 m_stringsSize = 0;
+};
+
+#endif // APPSTREAM_CACHE_H
@@ -0,0 +1,223 @@
+/***************************************************************************
+ *   Copyright (C) 2026 by agent                                           *
+ *   agent@local                                                           *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; see the file COPYING. If not, write to       *
+ *   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,  *
+ *   Boston, MA 02110-1301, USA.                                           *
+ ***************************************************************************/
+
+#include "DependencyGraph.h"
+
+#include <Daemon>
+
+#include <QLoggingCategory>
+
+Q_DECLARE_LOGGING_CATEGORY(APPER_LIB)
+
+using namespace PackageKit;
+
+DependencyGraph::DependencyGraph(QObject *parent)
+ : QObject(parent)
+{
+    // Anything we learned might be outdated once packages change
+    connect(Daemon::global(), &Daemon::updatesChanged, this, &DependencyGraph::clear);
+}
+
+DependencyGraph::~DependencyGraph()
+{
+    cancel();
+}
+
+void DependencyGraph::query(const QString &packageID, Direction direction, Transaction::Filters filters)
+{
+    cancel();
+
+    m_root = packageID;
+    m_direction = direction;
+    m_filters = filters;
+    m_level = 0;
+    m_running = true;
+    m_failed = false;
+    m_installedSize = 0;
+    m_visited.clear();
+    m_visited << packageID;
+    m_next.clear();
+
+    startLevel(QStringList() << packageID);
+}
+
+void DependencyGraph::cancel()
+{
+    for (Transaction *transaction : {m_edgesTransaction, m_sizesTransaction}) {
+        if (transaction) {
+            disconnect(transaction, nullptr, this, nullptr);
+            transaction->cancel();
+        }
+    }
+    m_edgesTransaction = nullptr;
+    m_sizesTransaction = nullptr;
+    m_running = false;
+}
+
+bool DependencyGraph::isRunning() const
+{
+    return m_running;
+}
+
+QStringList DependencyGraph::closure() const
+{
+    QSet<QString> ret = m_visited;
+    ret.remove(m_root);
+    return ret.toList();
+}
+
+int DependencyGraph::level() const
+{
+    return m_level;
+}
+
+qulonglong DependencyGraph::installedSize() const
+{
+    return m_installedSize;
+}
+
+void DependencyGraph::clear()
+{
+    m_closures.clear();
+    m_sizes.clear();
+}
+
+void DependencyGraph::package(Transaction::Info info, const QString &packageID, const QString &summary)
+{
+    Q_UNUSED(info)
+    Q_UNUSED(summary)
+    if (!m_visited.contains(packageID)) {
+        m_visited << packageID;
+        m_next << packageID;
+    }
+}
+
+void DependencyGraph::details(const Details &details)
+{
+    m_sizes[details.packageId()] = details.size();
+    m_installedSize += details.size();
+}
+
+void DependencyGraph::edgesFinished(Transaction::Exit status)
+{
+    if (status != Transaction::ExitSuccess) {
+        m_failed = true;
+    }
+
+    m_edgesTransaction = nullptr;
+    if (!m_sizesTransaction) {
+        levelDone();
+    }
+}
+
+void DependencyGraph::sizesFinished(Transaction::Exit status)
+{
+    Q_UNUSED(status)
+    m_sizesTransaction = nullptr;
+    if (!m_edgesTransaction) {
+        levelDone();
+    }
+}
+
+QString DependencyGraph::key(const QString &packageID) const
+{
+    return QString::number(m_direction) + QLatin1Char(':') +
+           QString::number(static_cast<qulonglong>(m_filters)) + QLatin1Char(':') +
+           packageID;
+}
+
+void DependencyGraph::startLevel(const QStringList &frontier)
+{
+    QStringList expand;
+    QStringList reached;
+    for (const QString &packageID : frontier) {
+        reached << packageID;
+
+        // An explored package brings its whole closure at once
+        auto it = m_closures.constFind(key(packageID));
+        if (it == m_closures.constEnd()) {
+            expand << packageID;
+            continue;
+        }
+
+        for (const QString &dependency : it.value()) {
+            if (!m_visited.contains(dependency)) {
+                m_visited << dependency;
+                reached << dependency;
+            }
+        }
+    }
+
+    QStringList missingSizes;
+    for (const QString &packageID : qAsConst(reached)) {
+        auto it = m_sizes.constFind(packageID);
+        if (it == m_sizes.constEnd()) {
+            missingSizes << packageID;
+        } else {
+            m_installedSize += it.value();
+        }
+    }
+
+    qCDebug(APPER_LIB) << "Level" << m_level << "expanding" << expand.size() << "packages, fetching" << missingSizes.size() << "sizes";
+
+    if (!expand.isEmpty()) {
+        if (m_direction == DependsOn) {
+            m_edgesTransaction = Daemon::dependsOn(expand, m_filters, false);
+        } else {
+            m_edgesTransaction = Daemon::requiredBy(expand, m_filters, false);
+        }
+        connect(m_edgesTransaction, &Transaction::package, this, &DependencyGraph::package);
+        connect(m_edgesTransaction, &Transaction::finished, this, &DependencyGraph::edgesFinished);
+    }
+
+    if (!missingSizes.isEmpty()) {
+        m_sizesTransaction = Daemon::getDetails(missingSizes);
+        connect(m_sizesTransaction, &Transaction::details, this, &DependencyGraph::details);
+        connect(m_sizesTransaction, &Transaction::finished, this, &DependencyGraph::sizesFinished);
+    }
+
+    if (!m_edgesTransaction && !m_sizesTransaction) {
+        levelDone();
+    }
+}
+
+void DependencyGraph::levelDone()
+{
+    emit levelFinished(m_level, m_visited.size() - 1, m_installedSize);
+
+    if (m_next.isEmpty()) {
+        // Only complete closures can be reused
+        if (!m_failed) {
+            QSet<QString> closure = m_visited;
+            closure.remove(m_root);
+            m_closures[key(m_root)] = closure;
+        }
+        m_running = false;
+        emit finished();
+        return;
+    }
+
+    const QStringList frontier = m_next.toList();
+    m_next.clear();
+    ++m_level;
+    startLevel(frontier);
+}
+
+#include "moc_DependencyGraph.cpp"
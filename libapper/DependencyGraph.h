@@ -0,0 +1,109 @@
+/***************************************************************************
+ *   Copyright (C) 2026 by agent                                           *
+ *   agent@local                                                           *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; see the file COPYING. If not, write to       *
+ *   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,  *
+ *   Boston, MA 02110-1301, USA.                                           *
+ ***************************************************************************/
+
+#ifndef DEPENDENCY_GRAPH_H
+#define DEPENDENCY_GRAPH_H
+
+#include <QObject>
+#include <QHash>
+#include <QSet>
+#include <QStringList>
+
+#include <Transaction>
+#include <Details>
+
+/**
+ * Expands the dependency (or reverse dependency) closure of a package
+ * breadth first, one batched PackageKit call per level, and sums the
+ * installed size of everything it reaches.
+ *
+ * Finished closures and package sizes are remembered until the package
+ * database changes, so later queries reaching an already explored
+ * package don't ask PackageKit about its subtree again.
+ */
+class Q_DECL_EXPORT DependencyGraph : public QObject
+{
+    Q_OBJECT
+public:
+    enum Direction {
+        DependsOn,
+        RequiredBy
+    };
+    explicit DependencyGraph(QObject *parent = nullptr);
+    ~DependencyGraph() override;
+
+    /**
+     * Starts expanding the closure of packageID, cancelling the
+     * running query if any
+     */
+    void query(const QString &packageID,
+               Direction direction,
+               PackageKit::Transaction::Filters filters = PackageKit::Transaction::FilterInstalled);
+    void cancel();
+    bool isRunning() const;
+
+    /**
+     * Packages reached so far, not including the queried one
+     */
+    QStringList closure() const;
+    int level() const;
+
+    /**
+     * Installed size of the queried package plus its closure,
+     * for reverse dependencies what removing it would free
+     */
+    qulonglong installedSize() const;
+
+public Q_SLOTS:
+    void clear();
+
+Q_SIGNALS:
+    void levelFinished(int level, int closureSize, qulonglong installedSize);
+    void finished();
+
+private Q_SLOTS:
+    void package(PackageKit::Transaction::Info info, const QString &packageID, const QString &summary);
+    void details(const PackageKit::Details &details);
+    void edgesFinished(PackageKit::Transaction::Exit status);
+    void sizesFinished(PackageKit::Transaction::Exit status);
+
+private:
+    QString key(const QString &packageID) const;
+    void startLevel(const QStringList &frontier);
+    void levelDone();
+
+    QString m_root;
+    Direction m_direction = RequiredBy;
+    PackageKit::Transaction::Filters m_filters;
+    int m_level = 0;
+    bool m_running = false;
+    bool m_failed = false;
+    qulonglong m_installedSize = 0;
+    QSet<QString> m_visited;
+    QSet<QString> m_next;
+    PackageKit::Transaction *m_edgesTransaction = nullptr;
+    PackageKit::Transaction *m_sizesTransaction = nullptr;
+
+    // Memoized across queries
+    QHash<QString, QSet<QString> > m_closures;
+    QHash<QString, qulonglong> m_sizes;
+};
+
+#endif
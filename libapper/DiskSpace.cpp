@@ -0,0 +1,190 @@
+/***************************************************************************
+ *   Copyright (C) 2026 by agent                                           *
+ *   agent@local                                                           *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; see the file COPYING. If not, write to       *
+ *   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,  *
+ *   Boston, MA 02110-1301, USA.                                           *
+ ***************************************************************************/
+
+#include "DiskSpace.h"
+
+#include <Daemon>
+
+#include <KLocalizedString>
+#include <KFormat>
+
+#include <QFileInfo>
+#include <QFile>
+#include <QLoggingCategory>
+
+#include <sys/stat.h>
+#include <sys/statvfs.h>
+
+Q_DECLARE_LOGGING_CATEGORY(APPER_LIB)
+
+// Package sizes are mostly compressed, unpacked they take about this much more
+#define INSTALL_SIZE_FACTOR 3
+// Below this much free space after the transaction we warn (64 MiB)
+#define SPACE_RESERVE (64ull * 1024 * 1024)
+
+using namespace PackageKit;
+
+DiskSpace::DiskSpace(QObject *parent) : QObject(parent)
+{
+}
+
+void DiskSpace::check(const QStringList &installing, const QStringList &updating, qulonglong downloadSize)
+{
+    m_updating = updating;
+    m_downloadSize = downloadSize;
+    m_estimatedDownload = 0;
+    m_installSize = 0;
+    m_updateSize = 0;
+
+    const QStringList packages = installing + updating;
+    if (packages.isEmpty()) {
+        detailsFinished();
+        return;
+    }
+
+    Transaction *transaction = Daemon::getDetails(packages);
+    connect(transaction, &Transaction::details, this, &DiskSpace::details);
+    connect(transaction, &Transaction::finished, this, &DiskSpace::detailsFinished);
+}
+
+void DiskSpace::setNotSimulated(const QStringList &packageIDs)
+{
+    m_notSimulated = packageIDs;
+}
+
+DiskSpace::Verdict DiskSpace::verdict() const
+{
+    return m_verdict;
+}
+
+QVector<DiskSpace::Mount> DiskSpace::mounts() const
+{
+    return m_mounts;
+}
+
+QString DiskSpace::report() const
+{
+    KFormat format;
+    QStringList lines;
+    for (const Mount &mount : m_mounts) {
+        if (mount.estimated + SPACE_RESERVE <= mount.available) {
+            continue;
+        }
+        lines << i18nc("Disk space on a mount point: path, needed size, free size",
+                       "%1 needs about %2, only %3 free",
+                       mount.path,
+                       format.formatByteSize(mount.estimated),
+                       format.formatByteSize(mount.available));
+    }
+    return lines.join(QLatin1String("<br>"));
+}
+
+void DiskSpace::details(const PackageKit::Details &details)
+{
+    if (m_updating.contains(details.packageId())) {
+        m_updateSize += details.size();
+    } else {
+        m_installSize += details.size();
+    }
+
+    if (m_notSimulated.contains(details.packageId())) {
+        m_estimatedDownload += details.size();
+    }
+}
+
+void DiskSpace::detailsFinished()
+{
+    m_mounts.clear();
+    m_devices.clear();
+
+    // The download must fit in the cache, what wasn't simulated might be
+    // cleaned from it in between so it only counts towards the estimate
+    addNeed(cacheDirectory(), m_downloadSize, m_downloadSize + m_estimatedDownload);
+    // A new package at least takes its own size on / and more once
+    // unpacked, an update mostly replaces the old files so only its
+    // new copy is counted, in case both exist while it is installed
+    addNeed(QLatin1String("/"),
+            m_installSize,
+            m_installSize * INSTALL_SIZE_FACTOR + m_updateSize);
+
+    m_verdict = Fits;
+    for (const Mount &mount : qAsConst(m_mounts)) {
+        if (mount.needed > mount.available) {
+            m_verdict = NoSpace;
+            break;
+        } else if (mount.estimated + SPACE_RESERVE > mount.available) {
+            m_verdict = Tight;
+        }
+    }
+    qCDebug(APPER_LIB) << "Disk space" << m_verdict << m_downloadSize << m_estimatedDownload << m_installSize << m_updateSize;
+
+    emit finished();
+}
+
+QString DiskSpace::cacheDirectory() const
+{
+    const QString backend = Daemon::global()->backendName();
+    if (backend == QLatin1String("aptcc")) {
+        return QLatin1String("/var/cache/apt/archives");
+    } else if (backend == QLatin1String("zypp")) {
+        return QLatin1String("/var/cache/zypp/packages");
+    } else if (backend == QLatin1String("alpm")) {
+        return QLatin1String("/var/cache/pacman/pkg");
+    }
+    return QLatin1String("/var/cache/PackageKit");
+}
+
+void DiskSpace::addNeed(const QString &path, qulonglong needed, qulonglong estimated)
+{
+    // The cache directory might not exist yet, it will be created
+    // on the filesystem of its closest existing parent
+    QString existing = path;
+    while (!QFileInfo::exists(existing) && existing != QLatin1String("/")) {
+        existing = QFileInfo(existing).absolutePath();
+    }
+
+    struct stat st;
+    struct statvfs vfs;
+    const QByteArray local = QFile::encodeName(existing);
+    if (stat(local.constData(), &st) != 0 || statvfs(local.constData(), &vfs) != 0) {
+        qCWarning(APPER_LIB) << "Could not get the free space of" << existing;
+        return;
+    }
+
+    const int index = m_devices.indexOf(st.st_dev);
+    if (index != -1) {
+        // Same filesystem, both go to the same free space
+        m_mounts[index].needed += needed;
+        m_mounts[index].estimated += estimated;
+        return;
+    }
+
+    Mount mount;
+    mount.path = path;
+    mount.needed = needed;
+    mount.estimated = estimated;
+    // f_bavail leaves out the blocks reserved to root, PackageKit runs
+    // as root but running the system out of them is not a good idea either
+    mount.available = qulonglong(vfs.f_bavail) * vfs.f_frsize;
+    m_mounts << mount;
+    m_devices << st.st_dev;
+}
+
+#include "moc_DiskSpace.cpp"
@@ -0,0 +1,97 @@
+/***************************************************************************
+ *   Copyright (C) 2026 by agent                                           *
+ *   agent@local                                                           *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; see the file COPYING. If not, write to       *
+ *   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,  *
+ *   Boston, MA 02110-1301, USA.                                           *
+ ***************************************************************************/
+
+#ifndef DISK_SPACE_H
+#define DISK_SPACE_H
+
+#include <QObject>
+#include <QStringList>
+#include <QVector>
+
+#include <Transaction>
+#include <Details>
+
+/**
+ * Estimates before a transaction downloads anything whether the
+ * package cache and the root filesystem have room for it.
+ *
+ * The download goes to the backend cache and the package sizes, taken
+ * from a single getDetails() call, to /; when both are on the same
+ * filesystem their needs add up. Packages that were not simulated have
+ * no download size, their package size is used as an estimate.
+ */
+class Q_DECL_EXPORT DiskSpace : public QObject
+{
+    Q_OBJECT
+public:
+    enum Verdict {
+        Fits,
+        Tight,  // Might not fit once the packages are unpacked
+        NoSpace // Can't even hold the download and the packages
+    };
+    struct Mount {
+        QString path;
+        qulonglong needed = 0;
+        qulonglong estimated = 0;
+        qulonglong available = 0;
+    };
+    explicit DiskSpace(QObject *parent = nullptr);
+
+    /**
+     * Asks for the sizes of the packages that will be installed
+     * or updated, finished() is emitted once the estimate is ready
+     */
+    void check(const QStringList &installing, const QStringList &updating, qulonglong downloadSize);
+    /**
+     * Packages in the check() lists that downloadSize doesn't
+     * cover, like the later batches of a large update
+     */
+    void setNotSimulated(const QStringList &packageIDs);
+
+    Verdict verdict() const;
+    QVector<DiskSpace::Mount> mounts() const;
+    /**
+     * Describes the mounts short of space
+     */
+    QString report() const;
+
+Q_SIGNALS:
+    void finished();
+
+private Q_SLOTS:
+    void details(const PackageKit::Details &details);
+    void detailsFinished();
+
+private:
+    QString cacheDirectory() const;
+    void addNeed(const QString &path, qulonglong needed, qulonglong estimated);
+
+    QStringList m_updating;
+    QStringList m_notSimulated;
+    qulonglong m_downloadSize = 0;
+    qulonglong m_estimatedDownload = 0;
+    qulonglong m_installSize = 0;
+    qulonglong m_updateSize = 0;
+    QVector<Mount> m_mounts;
+    QVector<qulonglong> m_devices;
+    Verdict m_verdict = Fits;
+};
+
+#endif
@@ -35,12 +35,28 @@
 #define CFG_INSTALL_UP_MOBILE  "installUpdatesOnMobile"
 #define CFG_AUTO_UP            "autoUpdate"
 #define CFG_INTERVAL           "interval"
+#define CFG_MIN_INTERVAL       "minInterval"
+#define CFG_MAX_INTERVAL       "maxInterval"
 #define CFG_DISTRO_UPGRADE     "distroUpgrade"
+#define CFG_MAX_PRESSURE       "maxPressure"
+#define CFG_MAX_LOAD           "maxLoadPerCpu"
+#define CFG_CALM_PERIOD        "calmPeriod"
+#define CFG_DOWNLOAD_BUDGET    "downloadBudget"
+#define CFG_PREPARE_OFFLINE    "prepareOfflineUpdates"
 
 #define DEFAULT_CHECK_UP_BATTERY   false
 #define DEFAULT_CHECK_UP_MOBILE    false
 #define DEFAULT_INSTALL_UP_BATTERY false
 #define DEFAULT_INSTALL_UP_MOBILE  false
+// Automatic updates wait until the stall percentage of CPU, IO and
+// memory and the load per CPU stayed below these for calmPeriod seconds
+#define DEFAULT_MAX_PRESSURE       10.0
+#define DEFAULT_MAX_LOAD           0.7
+#define DEFAULT_CALM_PERIOD        300
+// Average KiB/s updates are downloaded at ahead of time, 0 is unlimited
+#define DEFAULT_DOWNLOAD_BUDGET    512
+// Downloaded updates are staged for the next reboot instead of offered
+#define DEFAULT_PREPARE_OFFLINE    false
 
 namespace Enum {
 
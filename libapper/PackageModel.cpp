@@ -37,7 +37,6 @@
 #include <KFormat>
 
 #ifdef HAVE_APPSTREAM
-#include <AppStreamQt5/icon.h>
 #include <AppStream.h>
 #endif
 
@@ -48,6 +47,24 @@ using namespace PackageKit;
 
 Q_DECLARE_LOGGING_CATEGORY(APPER_LIB)
 
+#ifdef HAVE_APPSTREAM
+static void setApplication(PackageModel::InternalPackage &iPackage, const AppStreamHelper::Application &app)
+{
+    iPackage.isPackage = false;
+    if (!app.name.isEmpty()) {
+        iPackage.displayName = app.name;
+    }
+    if (!app.summary.isEmpty()) {
+        iPackage.summary = app.summary;
+    }
+    if (!app.icon.isEmpty()) {
+        iPackage.icon = app.icon;
+    }
+    iPackage.appId = app.id;
+    iPackage.size  = 0;
+}
+#endif // HAVE_APPSTREAM
+
 PackageModel::PackageModel(QObject *parent)
 : QAbstractItemModel(parent),
   m_finished(false),
@@ -70,6 +87,10 @@ PackageModel::PackageModel(QObject *parent)
     m_roles[IsPackageRole] = "rIsPackageRole";
     m_roles[PackageName] = "rPackageName";
     m_roles[InfoIconRole] = "rInfoIcon";
+
+#ifdef HAVE_APPSTREAM
+    connect(AppStreamHelper::instance(), &AppStreamHelper::ready, this, &PackageModel::appStreamReady);
+#endif // HAVE_APPSTREAM
 }
 
 void PackageModel::addSelectedPackagesFromModel(PackageModel *model)
@@ -103,42 +124,28 @@ void PackageModel::addPackage(Transaction::Info info, const QString &packageID,
     }
 
 #ifdef HAVE_APPSTREAM
-    QList<AppStream::Component> applications;
+    if (!AppStreamHelper::instance()->isReady()) {
+        // The pool is still loading, appStreamReady() will
+        // fill in the application data later
+        m_appStreamPending = true;
+    }
+
+    QList<AppStreamHelper::Application> applications;
     if (!m_checkable) {
         const QString packageName = Transaction::packageName(packageID);
         applications = AppStreamHelper::instance()->applications(packageName);
 
-        for (const AppStream::Component &app : applications) {
+        for (const AppStreamHelper::Application &app : applications) {
             InternalPackage iPackage;
             iPackage.info = info;
             iPackage.packageID = packageID;
             iPackage.pkgName = packageName;
+            iPackage.displayName = packageName;
             iPackage.version = Transaction::packageVersion(packageID);
             iPackage.arch = Transaction::packageArch(packageID);
             iPackage.repo = Transaction::packageData(packageID);
-            iPackage.isPackage = false;
-            if (app.name().isEmpty()) {
-                iPackage.displayName = packageName;
-            } else {
-                iPackage.displayName = app.name();
-            }
-            if (app.summary().isEmpty()) {
-                iPackage.summary = summary;
-            } else {
-                iPackage.summary = app.summary();
-            }
-
-            const QList<AppStream::Icon> icons = app.icons();
-            for (const AppStream::Icon &icon : icons) {
-                if (icon.url().isEmpty()) {
-                    iPackage.icon = icon.name();
-                } else {
-                    iPackage.icon = icon.url().toLocalFile();
-                }
-                break;
-            }
-            iPackage.appId = app.id();
-            iPackage.size  = 0;
+            iPackage.summary = summary;
+            setApplication(iPackage, app);
 
             if (selected) {
                 checkPackage(iPackage, false);
@@ -182,6 +189,71 @@ void PackageModel::addPackage(Transaction::Info info, const QString &packageID,
 #endif // HAVE_APPSTREAM
 }
 
+void PackageModel::appStreamReady()
+{
+#ifdef HAVE_APPSTREAM
+    if (!m_appStreamPending) {
+        return;
+    }
+    m_appStreamPending = false;
+
+    // The packages were added before the AppStream pool was
+    // loaded, enrich them now and notify the views only once
+    QVector<InternalPackage> extraApplications;
+    for (int i = 0; i < m_packages.size(); ++i) {
+        InternalPackage &iPackage = m_packages[i];
+        if (!iPackage.isPackage) {
+            continue;
+        }
+
+        // addPackage() asked for the icon while the pool was
+        // still empty, applications below might override it
+        iPackage.icon = AppStreamHelper::instance()->genericIcon(iPackage.pkgName);
+
+        const QList<AppStreamHelper::Application> applications = AppStreamHelper::instance()->applications(iPackage.pkgName);
+        if (applications.isEmpty()) {
+            continue;
+        }
+
+        if (m_checkable) {
+            // in case of updates model only check if it's an app
+            iPackage.isPackage = false;
+        } else {
+            // The first application takes the package row, packages
+            // providing more than one application get extra rows
+            const InternalPackage package = iPackage;
+            setApplication(iPackage, applications.first());
+            for (int j = 1; j < applications.size(); ++j) {
+                InternalPackage appPackage = package;
+                setApplication(appPackage, applications.at(j));
+                extraApplications.append(appPackage);
+            }
+        }
+
+        auto it = m_checkedPackages.find(iPackage.packageID);
+        if (it != m_checkedPackages.end()) {
+            it.value() = iPackage;
+        }
+    }
+
+    if (!m_finished) {
+        // finished() will insert all rows at once
+        m_packages << extraApplications;
+        return;
+    }
+
+    if (!extraApplications.isEmpty()) {
+        beginInsertRows(QModelIndex(), m_packages.size(), m_packages.size() + extraApplications.size() - 1);
+        m_packages << extraApplications;
+        endInsertRows();
+    }
+
+    if (!m_packages.isEmpty()) {
+        emit dataChanged(createIndex(0, 0), createIndex(m_packages.size() - 1, columnCount() - 1));
+    }
+#endif // HAVE_APPSTREAM
+}
+
 void PackageModel::addSelectedPackage(Transaction::Info info, const QString &packageID, const QString &summary)
 {
     addPackage(info, packageID, summary, true);
@@ -464,6 +536,7 @@ void PackageModel::clear()
     qDebug() << Q_FUNC_INFO;
     beginRemoveRows(QModelIndex(), 0, m_packages.size());
     m_finished = false;
+    m_appStreamPending = false;
     m_packages.clear();
     m_fetchSizesTransaction = nullptr;
     m_fetchInstalledVersionsTransaction = nullptr;
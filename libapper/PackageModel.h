@@ -138,6 +138,11 @@ public Q_SLOTS:
     void updateCurrentVersion(PackageKit::Transaction::Info info, const QString &packageID, const QString &summary);
 
     void getUpdates(bool fetchCurrentVersions, bool selected);
+    /**
+     * Adds the AppStream data to packages added while
+     * the AppStream pool was still loading
+     */
+    void appStreamReady();
     void toggleSelection(const QString &packageID);
     QString selectionStateText() const;
 
@@ -150,6 +155,7 @@ private:
     bool containsChecked(const QString &pid) const;
 
     bool                            m_finished = true;
+    bool                            m_appStreamPending = false;
     bool                            m_checkable;
     QPixmap                         m_installedEmblem;
     QVector<InternalPackage>        m_packages;
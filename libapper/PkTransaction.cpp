@@ -34,6 +34,7 @@
 #include <QtDBus/QDBusMessage>
 #include <QtDBus/QDBusConnection>
 #include <QTreeView>
+#include <QTimer>
 
 #include <Daemon>
 
@@ -45,16 +46,22 @@
 #include "ApplicationLauncher.h"
 #include "PackageModel.h"
 #include "Requirements.h"
+#include "DiskSpace.h"
 #include "PkTransactionProgressModel.h"
 #include "PkTransactionWidget.h"
 
 Q_DECLARE_LOGGING_CATEGORY(APPER_LIB)
 
+#define DEFAULT_PROGRESS_RATE 10
+// Larger update sets are split in batches of about this size
+#define UPDATE_BATCH_SIZE 50
+
 class PkTransactionPrivate
 {
 public:
     bool allowDeps;
     bool jobWatcher;
+    bool background;
     bool handlingActionRequired;
     bool showingError; //This might replace the above
     qulonglong downloadSizeRemaining;
@@ -65,6 +72,14 @@ public:
     Transaction::Error error;
     Transaction::Role role;
     QStringList packages;
+    // Updates left for the next batches, and what
+    // was not updated when a batch failed
+    QStringList pendingUpdates;
+    QStringList resumePackages;
+    // Set while a batched update has batches left to commit
+    bool batched;
+    // The space of a batched update is checked for all of it at once
+    bool spaceChecked;
     ApplicationLauncher *launcher;
     QStringList files;
     QStringList newPackages;
@@ -73,6 +88,9 @@ public:
     QWidget *parentWindow;
     QDBusObjectPath tid;
     Transaction *transaction;
+    QTimer *progressTimer;
+    int progressRate;
+    bool progressPending;
 };
 
 PkTransaction::PkTransaction(QObject *parent) :
@@ -82,8 +100,11 @@ PkTransaction::PkTransaction(QObject *parent) :
     // for sanity we are finished till some transaction is set
     d->allowDeps = false;
     d->jobWatcher = false;
+    d->background = false;
     d->handlingActionRequired = false;
     d->showingError = false;
+    d->batched = false;
+    d->spaceChecked = false;
     d->downloadSizeRemaining = 0;
     d->exitStatus = Success;
     d->status = Transaction::StatusUnknown;
@@ -97,6 +118,13 @@ PkTransaction::PkTransaction(QObject *parent) :
     d->progressModel = new PkTransactionProgressModel(this);
     d->parentWindow = qobject_cast<QWidget*>(parent);
     d->transaction = nullptr;
+
+    d->progressRate = DEFAULT_PROGRESS_RATE;
+    d->progressPending = false;
+    d->progressTimer = new QTimer(this);
+    d->progressTimer->setSingleShot(true);
+    d->progressTimer->setInterval(1000 / d->progressRate);
+    connect(d->progressTimer, &QTimer::timeout, this, &PkTransaction::emitProgress);
 }
 
 PkTransaction::~PkTransaction()
@@ -151,6 +179,19 @@ void PkTransaction::updatePackages(const QStringList &packages, bool downloadOnl
 //    if (Daemon::global()->roles() & Transaction::RoleUpdatePackages) {
         d->originalRole = Transaction::RoleUpdatePackages;
         d->packages = packages;
+        d->pendingUpdates.clear();
+        d->resumePackages.clear();
+        d->newPackages.clear();
+        d->batched = !downloadOnly && packages.size() > UPDATE_BATCH_SIZE;
+        d->spaceChecked = false;
+        if (d->batched) {
+            // Simulating a huge set is slow and a failure near its end
+            // rolls everything back, so update it in batches that are
+            // simulated and committed one after the other
+            d->packages = packages.mid(0, UPDATE_BATCH_SIZE);
+            d->pendingUpdates = packages.mid(UPDATE_BATCH_SIZE);
+        }
+
         if (downloadOnly) {
             // Don't simulate if we are just downloading
             d->flags = Transaction::TransactionFlagOnlyDownload;
@@ -382,8 +423,13 @@ void PkTransaction::slotFinished(Transaction::Exit status)
     // Clear the model to don't keep trash when reusing the transaction
     d->progressModel->clear();
 
-    Requirements *requires = nullptr;
     Transaction::Role _role = qobject_cast<Transaction*>(sender())->role();
+
+    // Deliver the final state while we can still read it
+    if (d->progressPending) {
+        d->progressTimer->stop();
+        emitProgress();
+    }
     d->transaction = nullptr; // Will be deleted later
     qCDebug(APPER_LIB) << status << _role;
 
@@ -409,31 +455,50 @@ void PkTransaction::slotFinished(Transaction::Exit status)
             d->flags ^= Transaction::TransactionFlagSimulate;
             d->simulateModel->finished();
 
+            if (_role == Transaction::RoleUpdatePackages && !d->pendingUpdates.isEmpty()) {
+                // Pending updates this batch pulls in go with it, so the
+                // batch is closed over the dependencies the backend found
+                const QStringList updating = d->simulateModel->packagesWithInfo(Transaction::InfoUpdating);
+                for (const QString &packageID : updating) {
+                    if (d->pendingUpdates.removeOne(packageID)) {
+                        d->packages << packageID;
+                    }
+                }
+            }
+
             // Remove the transaction packages
             for (const QString &packageID : qAsConst(d->packages)) {
                 d->simulateModel->removePackage(packageID);
             }
 
-            d->newPackages = d->simulateModel->packagesWithInfo(Transaction::InfoInstalling);
+            if (_role == Transaction::RoleUpdatePackages && !d->newPackages.isEmpty()) {
+                // Batches add up to what the last one shows
+                d->newPackages << d->simulateModel->packagesWithInfo(Transaction::InfoInstalling);
+                d->newPackages.removeDuplicates();
+            } else {
+                d->newPackages = d->simulateModel->packagesWithInfo(Transaction::InfoInstalling);
+            }
             if (_role == Transaction::RoleInstallPackages) {
                 d->newPackages << d->packages;
                 d->newPackages.removeDuplicates();
             }
 
-            requires = new Requirements(d->simulateModel, d->parentWindow);
-            requires->setDownloadSizeRemaining(d->downloadSizeRemaining);
-            connect(requires, &Requirements::accepted, this, &PkTransaction::requeueTransaction);
-            connect(requires, &Requirements::rejected, this, &PkTransaction::reject);
-            if (requires->shouldShow()) {
-                showDialog(requires);
+            if (_role == Transaction::RoleRemovePackages) {
+                showRequirements();
             } else {
-                requires->deleteLater();
-
-                // Since we removed the Simulate Flag this will procced
-                // with the actual action
-                requeueTransaction();
+                checkDiskSpace();
             }
+        } else if (_role == Transaction::RoleUpdatePackages && !d->pendingUpdates.isEmpty()) {
+            // This batch is committed, simulate the next one
+            qCDebug(APPER_LIB) << "Updated a batch of" << d->packages.size() << d->pendingUpdates.size() << "left";
+            d->packages = d->pendingUpdates.mid(0, UPDATE_BATCH_SIZE);
+            d->pendingUpdates = d->pendingUpdates.mid(UPDATE_BATCH_SIZE);
+            d->flags |= Transaction::TransactionFlagSimulate;
+            setupTransaction(Daemon::updatePackages(d->packages, d->flags));
         } else {
+            // Nothing is left to resume once the last batch is committed
+            d->batched = false;
+
             KConfig config(QLatin1String("apper"));
             KConfigGroup transactionGroup(&config, "Transaction");
             bool showApp = transactionGroup.readEntry("ShowApplicationLauncher", true);
@@ -576,6 +641,61 @@ Transaction::TransactionFlags PkTransaction::transactionFlags() const
     return Transaction::TransactionFlagNone;
 }
 
+PkTransaction::Progress PkTransaction::progress() const
+{
+    Progress ret;
+    if (d->transaction) {
+        ret.percentage = d->transaction->percentage();
+        ret.remainingTime = d->transaction->remainingTime();
+        ret.speed = d->transaction->speed();
+        ret.downloadSizeRemaining = d->transaction->downloadSizeRemaining();
+        ret.status = d->transaction->status();
+        ret.role = d->transaction->role();
+        ret.allowCancel = d->transaction->allowCancel();
+        ret.transactionFlags = d->transaction->transactionFlags();
+    }
+    return ret;
+}
+
+void PkTransaction::setProgressRate(int updatesPerSecond)
+{
+    d->progressRate = qMax(0, updatesPerSecond);
+    d->progressTimer->setInterval(d->progressRate ? 1000 / d->progressRate : 0);
+}
+
+int PkTransaction::progressRate() const
+{
+    return d->progressRate;
+}
+
+void PkTransaction::progressChanged()
+{
+    if (d->progressRate == 0) {
+        emit progressUpdated(progress());
+        return;
+    }
+
+    // The first change goes out right away, the ones arriving
+    // within the interval are folded into a single update
+    if (d->progressTimer->isActive()) {
+        d->progressPending = true;
+    } else {
+        d->progressPending = false;
+        emit progressUpdated(progress());
+        d->progressTimer->start();
+    }
+}
+
+void PkTransaction::emitProgress()
+{
+    if (d->progressPending) {
+        d->progressPending = false;
+        emit progressUpdated(progress());
+        // keep the window open so a steady stream stays at the rate
+        d->progressTimer->start();
+    }
+}
+
 void PkTransaction::getUpdateDetail(const QString &packageID)
 {
     setupTransaction(Daemon::getUpdateDetail(packageID));
@@ -611,6 +731,14 @@ void PkTransaction::setExitStatus(int status)
     }
 
     d->exitStatus = static_cast<PkTransaction::ExitStatus>(status);
+    if (d->exitStatus != Success && d->batched) {
+        // The batches before this one are installed, this
+        // one might be the last and have none pending
+        d->resumePackages = d->packages + d->pendingUpdates;
+        d->pendingUpdates.clear();
+        d->batched = false;
+    }
+
     if (!d->handlingActionRequired || !d->showingError) {
         emit finished(d->exitStatus);
     }
@@ -653,6 +781,15 @@ void PkTransaction::setupTransaction(Transaction *transaction)
     connect(transaction, &Transaction::transactionFlagsChanged, this, &PkTransaction::transactionFlagsChanged);
     connect(transaction, &Transaction::uidChanged, this, &PkTransaction::uidChanged);
 
+    connect(transaction, &Transaction::allowCancelChanged, this, &PkTransaction::progressChanged);
+    connect(transaction, &Transaction::downloadSizeRemainingChanged, this, &PkTransaction::progressChanged);
+    connect(transaction, &Transaction::percentageChanged, this, &PkTransaction::progressChanged);
+    connect(transaction, &Transaction::remainingTimeChanged, this, &PkTransaction::progressChanged);
+    connect(transaction, &Transaction::roleChanged, this, &PkTransaction::progressChanged);
+    connect(transaction, &Transaction::speedChanged, this, &PkTransaction::progressChanged);
+    connect(transaction, &Transaction::statusChanged, this, &PkTransaction::progressChanged);
+    connect(transaction, &Transaction::transactionFlagsChanged, this, &PkTransaction::progressChanged);
+
     connect(transaction, &Transaction::downloadSizeRemainingChanged, this, &PkTransaction::slotChanged);
     connect(transaction, &Transaction::errorCode, this, &PkTransaction::slotErrorCode);
     connect(transaction, &Transaction::eulaRequired, this, &PkTransaction::slotEulaRequired);
@@ -666,6 +803,13 @@ void PkTransaction::setupTransaction(Transaction *transaction)
         connect(d->transaction, &Transaction::package, d->simulateModel, &PackageModel::addNotSelectedPackage);
     }
 
+    QStringList hints;
+    if (d->background) {
+        // PackageKit lowers the priority of the backend and
+        // lets other transactions go first
+        hints << QLatin1String("background=true");
+    }
+
 #ifdef HAVE_DEBCONFKDE
     QString _tid = transaction->tid().path();
     QString socket;
@@ -689,8 +833,12 @@ void PkTransaction::setupTransaction(Transaction *transaction)
         qCWarning(APPER_LIB) << "Failed to put SetupDebconfDialog message in DBus queue";
     }
 
-    transaction->setHints(QLatin1String("frontend-socket=") % socket);
+    hints << QLatin1String("frontend-socket=") % socket;
 #endif //HAVE_DEBCONFKDE
+
+    if (!hints.isEmpty()) {
+        transaction->setHints(hints);
+    }
 }
 
 void PkTransaction::showDialog(QDialog *dlg)
@@ -737,6 +885,77 @@ void PkTransaction::showSorry(const QString &title, const QString &description,
     }
 }
 
+void PkTransaction::checkDiskSpace()
+{
+    if (d->batched && d->spaceChecked) {
+        // The first batch checked for the whole update
+        showRequirements();
+        return;
+    }
+
+    // Find out before downloading anything if there is room for it,
+    // otherwise the transaction fails halfway through
+    QStringList installing = d->simulateModel->packagesWithInfo(Transaction::InfoInstalling);
+    QStringList updating = d->simulateModel->packagesWithInfo(Transaction::InfoUpdating);
+    if (d->originalRole == Transaction::RoleUpdatePackages) {
+        // The later batches are only simulated once
+        // the earlier ones were committed, too late
+        updating << d->packages << d->pendingUpdates;
+    } else if (d->originalRole == Transaction::RoleInstallPackages) {
+        installing << d->packages;
+    }
+
+    auto space = new DiskSpace(this);
+    space->setNotSimulated(d->pendingUpdates);
+    connect(space, &DiskSpace::finished, this, [this, space] () {
+        space->deleteLater();
+        if (space->verdict() == DiskSpace::NoSpace) {
+            d->showingError = true;
+            showSorry(i18n("Not enough disk space"),
+                      i18n("There is not enough free disk space to download and install the packages."),
+                      space->report());
+            setExitStatus(Failed);
+            return;
+        } else if (space->verdict() == DiskSpace::Tight && !d->background) {
+            int ret = KMessageBox::warningContinueCancel(d->parentWindow,
+                                                         i18n("The disk might run out of space while installing the packages.<br>%1",
+                                                              space->report()),
+                                                         i18n("Low disk space"));
+            if (ret != KMessageBox::Continue) {
+                setExitStatus(Cancelled);
+                return;
+            }
+        } else if (space->verdict() == DiskSpace::Tight) {
+            qCWarning(APPER_LIB) << "Low disk space for the transaction" << space->report();
+        }
+        d->spaceChecked = true;
+        showRequirements();
+    });
+    space->check(installing, updating, d->downloadSizeRemaining);
+}
+
+void PkTransaction::showRequirements()
+{
+    auto requirements = new Requirements(d->simulateModel, d->parentWindow);
+    requirements->setDownloadSizeRemaining(d->downloadSizeRemaining);
+    connect(requirements, &Requirements::accepted, this, &PkTransaction::requeueTransaction);
+    connect(requirements, &Requirements::rejected, this, &PkTransaction::reject);
+    if (requirements->shouldShow()) {
+        showDialog(requirements);
+    } else {
+        requirements->deleteLater();
+
+        // Since we removed the Simulate Flag this will procced
+        // with the actual action
+        requeueTransaction();
+    }
+}
+
+QStringList PkTransaction::resumePackages() const
+{
+    return d->resumePackages;
+}
+
 QString PkTransaction::title() const
 {
     return PkStrings::action(d->originalRole, d->flags);
@@ -762,4 +981,14 @@ void PkTransaction::enableJobWatcher(bool enable)
     d->jobWatcher = enable;
 }
 
+void PkTransaction::setBackground(bool background)
+{
+    d->background = background;
+}
+
+bool PkTransaction::isBackground() const
+{
+    return d->background;
+}
+
 #include "moc_PkTransaction.cpp"
@@ -42,6 +42,20 @@ public:
         Failed,
         Cancelled
     } ExitStatus;
+    /**
+     * A consistent copy of all the progress fields of the
+     * running transaction, as delivered by progressUpdated()
+     */
+    struct Progress {
+        uint percentage = 0;
+        uint remainingTime = 0;
+        uint speed = 0;
+        qulonglong downloadSizeRemaining = 0;
+        Transaction::Status status = Transaction::StatusUnknown;
+        Transaction::Role role = Transaction::RoleUnknown;
+        bool allowCancel = false;
+        Transaction::TransactionFlags transactionFlags = Transaction::TransactionFlagNone;
+    };
     explicit PkTransaction(QObject *parent = nullptr);
     ~PkTransaction() override;
 
@@ -59,12 +73,32 @@ public:
     Transaction::TransactionFlags flags() const;
     Q_INVOKABLE PkTransactionProgressModel* progressModel() const;
     Q_INVOKABLE void enableJobWatcher(bool enable);
+    /**
+     * Asks PackageKit to run the next transactions with the lowest
+     * priority, for work the user didn't explicitly ask for
+     */
+    void setBackground(bool background);
+    bool isBackground() const;
 
     PkTransaction::ExitStatus exitStatus() const;
     bool isFinished() const;
+    /**
+     * Large updates run in batches, when one of them fails these are
+     * the updates it and the following ones had, the earlier batches
+     * are installed so updatePackages() with these carries on
+     */
+    QStringList resumePackages() const;
 
     PackageModel* simulateModel() const;
 
+    Progress progress() const;
+    /**
+     * Limits progressUpdated() to \p updatesPerSecond emissions,
+     * 0 emits on every change, the last state is always delivered
+     */
+    void setProgressRate(int updatesPerSecond);
+    int progressRate() const;
+
     Q_PROPERTY(uint percentage READ percentage NOTIFY percentageChanged)
     uint percentage() const;
 
@@ -120,6 +154,7 @@ Q_SIGNALS:
     void sorry(const QString &title, const QString &text, const QString &details);
     void errorMessage(const QString &title, const QString &text, const QString &details);
     void dialog(QDialog *widget);
+    void progressUpdated(const PkTransaction::Progress &progress);
 
     void allowCancelChanged();
     void isCallerActiveChanged();
@@ -141,6 +176,8 @@ private Q_SLOTS:
     void updatePackages();
 
     void slotChanged();
+    void progressChanged();
+    void emitProgress();
     void slotFinished(PackageKit::Transaction::Exit status);
     void slotErrorCode(PackageKit::Transaction::Error error, const QString &details);
     void slotEulaRequired(const QString &eulaID, const QString &packageID, const QString &vendor, const QString &licenseAgreement);
@@ -161,8 +198,12 @@ private:
     void showDialog(QDialog *dialog);
     void showError(const QString &title, const QString &description, const QString &details = QString());
     void showSorry(const QString &title, const QString &description, const QString &details = QString());
+    void checkDiskSpace();
+    void showRequirements();
 
     PkTransactionPrivate *d;
 };
 
+Q_DECLARE_METATYPE(PkTransaction::Progress)
+
 #endif
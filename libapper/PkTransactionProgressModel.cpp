@@ -21,6 +21,7 @@
 #include "PkTransactionProgressModel.h"
 
 #include <QLoggingCategory>
+#include <QTimer>
 
 #include <PkStrings.h>
 
@@ -31,9 +32,13 @@ Q_DECLARE_LOGGING_CATEGORY(APP_LIB)
 using namespace PackageKit;
 
 PkTransactionProgressModel::PkTransactionProgressModel(QObject *parent) :
-    QStandardItemModel(parent)
+    QAbstractTableModel(parent)
 {
-
+    // Backends report progress much faster than the screen refreshes
+    m_changesTimer = new QTimer(this);
+    m_changesTimer->setSingleShot(true);
+    m_changesTimer->setInterval(16);
+    connect(m_changesTimer, &QTimer::timeout, this, &PkTransactionProgressModel::emitChanges);
 }
 
 PkTransactionProgressModel::~PkTransactionProgressModel()
@@ -49,10 +54,11 @@ void PkTransactionProgressModel::currentRepo(const QString &repoId, const QStrin
         return;
     }
 
-    auto stdItem = new QStandardItem(description);
-    stdItem->setData(repoId, RoleId);
-    stdItem->setData(true,   RoleRepo);
-    appendRow(stdItem);
+    Item item;
+    item.id = repoId;
+    item.text = description;
+    item.repo = true;
+    append(item);
 }
 
 void PkTransactionProgressModel::itemProgress(const QString &id, Transaction::Status status, uint percentage)
@@ -64,21 +70,111 @@ void PkTransactionProgressModel::itemProgress(const QString &id, Transaction::St
         return;
     }
 
-    QStandardItem *stdItem = findLastItem(id);
-    if (stdItem && !stdItem->data(RoleFinished).toBool()) {
+    auto it = m_rows.constFind(id);
+    if (it == m_rows.constEnd()) {
+        return;
+    }
+
+    Item &item = m_items[it.value()];
+    if (!item.finished) {
         // if the progress is unknown (101), make it empty
         if (percentage == 101) {
             percentage = 0;
         }
-        if (stdItem->data(RoleProgress).toUInt() != percentage) {
-            stdItem->setData(percentage, RoleProgress);
+        if (item.progress != percentage) {
+            item.progress = percentage;
+            rowChanged(it.value());
         }
     }
 }
 
 void PkTransactionProgressModel::clear()
 {
-    removeRows(0, rowCount());
+    beginResetModel();
+    m_items.clear();
+    m_rows.clear();
+    m_finished = 0;
+    m_changedFirst = -1;
+    m_changedLast = -1;
+    m_changesTimer->stop();
+    endResetModel();
+}
+
+void PkTransactionProgressModel::setColumnCount(int columns)
+{
+    if (m_columns == columns) {
+        return;
+    }
+
+    beginResetModel();
+    m_columns = columns;
+    endResetModel();
+}
+
+int PkTransactionProgressModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : m_items.size();
+}
+
+int PkTransactionProgressModel::columnCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : m_columns;
+}
+
+QVariant PkTransactionProgressModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || index.row() >= m_items.size()) {
+        return QVariant();
+    }
+
+    const Item &item = m_items.at(index.row());
+    switch (index.column()) {
+    case 0:
+        switch (role) {
+        case Qt::DisplayRole:
+            if (item.repo) {
+                return item.text;
+            }
+            return item.finished ? PkStrings::infoPast(item.info) : PkStrings::infoPresent(item.info);
+        case RoleId:
+            return item.id;
+        case RoleRepo:
+            return item.repo;
+        }
+
+        if (item.repo) {
+            // Repositories only have a description
+            return QVariant();
+        }
+
+        switch (role) {
+        case RoleInfo:
+            return qVariantFromValue(item.info);
+        case RolePkgName:
+            return Transaction::packageName(item.id);
+        case RolePkgSummary:
+            return item.summary;
+        case RoleFinished:
+            return item.finished;
+        case RoleProgress:
+            return item.progress;
+        }
+        break;
+    case 1:
+        if (!item.repo && role == Qt::DisplayRole) {
+            return Transaction::packageName(item.id);
+        } else if (!item.repo && role == Qt::ToolTipRole) {
+            return Transaction::packageVersion(item.id);
+        }
+        break;
+    case 2:
+        if (!item.repo && (role == Qt::DisplayRole || role == Qt::ToolTipRole)) {
+            return item.summary;
+        }
+        break;
+    }
+
+    return QVariant();
 }
 
 QHash<int, QByteArray> PkTransactionProgressModel::roleNames() const
@@ -105,93 +201,93 @@ void PkTransactionProgressModel::currentPackage(PackageKit::Transaction::Info in
     }
 
     if (!packageID.isEmpty()) {
-        QStandardItem *stdItem = findLastItem(packageID);
+        auto it = m_rows.constFind(packageID);
         // If there is alread some packages check to see if it has
         // finished, if the progress is 100 create a new item for the next task
-        if (stdItem && !stdItem->data(RoleFinished).toBool()) {
+        if (it != m_rows.constEnd() && !m_items.at(it.value()).finished) {
+            const int row = it.value();
             // if the item status (info) changed update it
-            if (stdItem->data(RoleInfo).value<Transaction::Info>() != info) {
+            if (m_items.at(row).info != info) {
                 // If the package task has finished set progress to 100
                 if (info == Transaction::InfoFinished) {
-                    itemFinished(stdItem);
+                    itemFinished(row);
                 } else {
-                    stdItem->setData(qVariantFromValue(info), RoleInfo);
-                    stdItem->setText(PkStrings::infoPresent(info));
+                    m_items[row].info = info;
+                    rowChanged(row);
                 }
             }
         } else if (info != Transaction::InfoFinished) {
-            QList<QStandardItem *> items;
             // It's a new package create it and append it
-            stdItem = new QStandardItem;
-            stdItem->setText(PkStrings::infoPresent(info));
-            stdItem->setData(Transaction::packageName(packageID), RolePkgName);
-            stdItem->setData(summary, RolePkgSummary);
-            stdItem->setData(qVariantFromValue(info), RoleInfo);
-            stdItem->setData(0,         RoleProgress);
-            stdItem->setData(false,     RoleFinished);
-            stdItem->setData(packageID, RoleId);
-            stdItem->setData(false,     RoleRepo);
-            items << stdItem;
-
-            stdItem = new QStandardItem(Transaction::packageName(packageID));
-            stdItem->setToolTip(Transaction::packageVersion(packageID));
-            items << stdItem;
-
-            stdItem = new QStandardItem(summary);
-            stdItem->setToolTip(summary);
-            items << stdItem;
-
-            appendRow(items);
+            Item item;
+            item.id = packageID;
+            item.summary = summary;
+            item.info = info;
+            append(item);
         }
     }
 }
 
-void PkTransactionProgressModel::itemFinished(QStandardItem *stdItem)
+void PkTransactionProgressModel::emitChanges()
 {
-    // Point to the item before it
-    int count = stdItem->row() - 1;
-
-    // Find the last finished item
-    bool found = false;
-    while (count >= 0) {
-        // Put it after the finished item
-        // so that running items can be kept
-        // at the bottom
-        if (item(count)->data(RoleFinished).toBool()) {
-            // make sure it won't end in the same position
-            if (count + 1 != stdItem->row()) {
-                QList<QStandardItem*> items;
-                items = takeRow(stdItem->row());
-                insertRow(count + 1, items);
-            }
-            found = true;
-            break;
-        }
-        --count;
+    m_changesTimer->stop();
+    if (m_changedFirst == -1) {
+        return;
     }
 
-    // If it's not at the top of the list
-    // and no FINISHED Item was found move it there
-    if (!found && stdItem->row() != 0) {
-        insertRow(0, takeRow(stdItem->row()));
-    }
+    emit dataChanged(index(m_changedFirst, 0), index(m_changedLast, m_columns - 1));
+    m_changedFirst = -1;
+    m_changedLast = -1;
+}
 
-    Transaction::Info info = stdItem->data(RoleInfo).value<Transaction::Info>();
-    stdItem->setText(PkStrings::infoPast(info));
-    stdItem->setData(100,  RoleProgress);
-    stdItem->setData(true, RoleFinished);
+void PkTransactionProgressModel::append(const Item &item)
+{
+    const int row = m_items.size();
+    beginInsertRows(QModelIndex(), row, row);
+    m_items.append(item);
+    m_rows[item.id] = row;
+    endInsertRows();
 }
 
-QStandardItem* PkTransactionProgressModel::findLastItem(const QString &packageID)
+void PkTransactionProgressModel::itemFinished(int row)
 {
-    int rows = rowCount() - 1;
-    for (int i = rows; i >= 0; --i) {
-        QStandardItem *stdItem = item(i);
-        if (stdItem->data(RoleId).toString() == packageID) {
-            return stdItem;
+    // Swap it with the first running item, so that finished
+    // items stay at the top and running ones at the bottom
+    const int first = m_finished++;
+    if (row != first) {
+        qSwap(m_items[row], m_items[first]);
+
+        // Only update the hash for rows it points to, an older
+        // item of the same package must not take over
+        auto it = m_rows.find(m_items.at(row).id);
+        if (it != m_rows.end() && it.value() == first) {
+            it.value() = row;
         }
+        it = m_rows.find(m_items.at(first).id);
+        if (it != m_rows.end() && it.value() == row) {
+            it.value() = first;
+        }
+        rowChanged(row);
+    }
+
+    Item &item = m_items[first];
+    item.progress = 100;
+    item.finished = true;
+    rowChanged(first);
+}
+
+void PkTransactionProgressModel::rowChanged(int row)
+{
+    if (m_changedFirst == -1) {
+        m_changedFirst = row;
+        m_changedLast = row;
+    } else {
+        m_changedFirst = qMin(m_changedFirst, row);
+        m_changedLast = qMax(m_changedLast, row);
+    }
+
+    if (!m_changesTimer->isActive()) {
+        m_changesTimer->start();
     }
-    return nullptr;
 }
 
 #include "moc_PkTransactionProgressModel.cpp"
@@ -21,13 +21,25 @@
 #ifndef PK_TRANSACTION_PROGRESS_MODEL_H
 #define PK_TRANSACTION_PROGRESS_MODEL_H
 
-#include <QStandardItemModel>
+#include <QAbstractTableModel>
+#include <QHash>
+#include <QVector>
 
 #include <Transaction>
 
 //#include <kdemacros.h>
 
-class Q_DECL_EXPORT PkTransactionProgressModel: public QStandardItemModel
+class QTimer;
+
+/**
+ * Packages and repositories a transaction went through.
+ *
+ * Finished items are kept in a block at the top and running ones
+ * below it, an item finishing swaps places with the first running
+ * one so rows never move, and progress changes are reported at
+ * most once per frame.
+ */
+class Q_DECL_EXPORT PkTransactionProgressModel: public QAbstractTableModel
 {
     Q_OBJECT
 public:
@@ -44,6 +56,11 @@ public:
     ~PkTransactionProgressModel() override;
 
     void clear();
+    void setColumnCount(int columns);
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
 
     QHash<int,QByteArray> roleNames() const override;
 
@@ -52,9 +69,32 @@ public Q_SLOTS:
     void currentRepo(const QString &repoId, const QString &description, bool enabled);
     void itemProgress(const QString &id, PackageKit::Transaction::Status status, uint percentage);
 
+private Q_SLOTS:
+    void emitChanges();
+
 private:
-    void itemFinished(QStandardItem *stdItem);
-    QStandardItem* findLastItem(const QString &packageID);
+    struct Item {
+        QString id;
+        QString text;
+        QString summary;
+        PackageKit::Transaction::Info info = PackageKit::Transaction::InfoUnknown;
+        uint progress = 0;
+        bool finished = false;
+        bool repo = false;
+    };
+
+    void append(const Item &item);
+    void itemFinished(int row);
+    void rowChanged(int row);
+
+    QVector<Item> m_items;
+    // Last row of each id, packages might show up again after finishing
+    QHash<QString, int> m_rows;
+    int m_finished = 0;
+    int m_columns = 3;
+    int m_changedFirst = -1;
+    int m_changedLast = -1;
+    QTimer *m_changesTimer;
 };
 
 #endif // PK_TRANSACTION_PROGRESS_MODEL_H
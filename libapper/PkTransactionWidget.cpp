@@ -131,14 +131,7 @@ void PkTransactionWidget::setTransaction(PkTransaction *trans, Transaction::Role
         ui->progressView->header()->setSectionResizeMode(2, QHeaderView::Stretch);
     }
 
-    connect(m_trans, &PkTransaction::percentageChanged, this, &PkTransactionWidget::updateUi);
-    connect(m_trans, &PkTransaction::speedChanged, this, &PkTransactionWidget::updateUi);
-    connect(m_trans, &PkTransaction::statusChanged, this, &PkTransactionWidget::updateUi);
-    connect(m_trans, &PkTransaction::downloadSizeRemainingChanged, this, &PkTransactionWidget::updateUi);
-    connect(m_trans, &PkTransaction::remainingTimeChanged, this, &PkTransactionWidget::updateUi);
-    connect(m_trans, &PkTransaction::roleChanged, this, &PkTransactionWidget::updateUi);
-    connect(m_trans, &PkTransaction::allowCancelChanged, this, &PkTransactionWidget::updateUi);
-    connect(m_trans, &PkTransaction::transactionFlagsChanged, this, &PkTransactionWidget::updateUi);
+    connect(m_trans, &PkTransaction::progressUpdated, this, &PkTransactionWidget::updateUi);
 
     // Forward Q_SIGNALS:
     connect(m_trans, &PkTransaction::sorry, this, &PkTransactionWidget::sorry);
@@ -155,14 +148,7 @@ void PkTransactionWidget::unsetTransaction()
         return;
     }
 
-    connect(m_trans, &PkTransaction::percentageChanged, this, &PkTransactionWidget::updateUi);
-    connect(m_trans, &PkTransaction::speedChanged, this, &PkTransactionWidget::updateUi);
-    connect(m_trans, &PkTransaction::statusChanged, this, &PkTransactionWidget::updateUi);
-    connect(m_trans, &PkTransaction::downloadSizeRemainingChanged, this, &PkTransactionWidget::updateUi);
-    connect(m_trans, &PkTransaction::remainingTimeChanged, this, &PkTransactionWidget::updateUi);
-    connect(m_trans, &PkTransaction::roleChanged, this, &PkTransactionWidget::updateUi);
-    connect(m_trans, &PkTransaction::allowCancelChanged, this, &PkTransactionWidget::updateUi);
-    connect(m_trans, &PkTransaction::transactionFlagsChanged, this, &PkTransactionWidget::updateUi);
+    disconnect(m_trans, &PkTransaction::progressUpdated, this, &PkTransactionWidget::updateUi);
 }
 
 void PkTransactionWidget::updateUi()
@@ -174,7 +160,8 @@ void PkTransactionWidget::updateUi()
         return;
     }
 
-    uint percentage = transaction->percentage();
+    const PkTransaction::Progress progress = transaction->progress();
+    uint percentage = progress.percentage;
     QString percentageString;
     if (percentage <= 100) {
         if (ui->progressBar->value() != static_cast<int>(percentage)) {
@@ -188,12 +175,12 @@ void PkTransactionWidget::updateUi()
         percentageString = QLatin1String("");
     }
 
-    ui->progressBar->setRemaining(transaction->remainingTime());
+    ui->progressBar->setRemaining(progress.remainingTime);
 
     // Status & Speed
-    Transaction::Status status = transaction->status();
-    uint speed = transaction->speed();
-    qulonglong downloadSizeRemaining = transaction->downloadSizeRemaining();
+    Transaction::Status status = progress.status;
+    uint speed = progress.speed;
+    qulonglong downloadSizeRemaining = progress.downloadSizeRemaining;
     if (m_status != status) {
         m_status = status;
         ui->currentL->setText(PkStrings::status(status,
@@ -215,7 +202,7 @@ void PkTransactionWidget::updateUi()
     QString windowTitle;
     QString windowTitleProgress;
     QIcon windowIcon;
-    Transaction::Role role = transaction->role();
+    Transaction::Role role = progress.role;
     if (role == Transaction::RoleUnknown) {
         windowTitle  = PkStrings::status(Transaction::StatusSetup);
         if (percentageString.isEmpty()) {
@@ -230,7 +217,7 @@ void PkTransactionWidget::updateUi()
         }
         windowIcon = PkIcons::statusIcon(Transaction::StatusSetup);
     } else {
-        windowTitle = PkStrings::action(role, transaction->transactionFlags());
+        windowTitle = PkStrings::action(role, progress.transactionFlags);
         if (percentageString.isEmpty()) {
             windowTitleProgress = PkStrings::status(status,
                                                     speed,
@@ -256,7 +243,7 @@ void PkTransactionWidget::updateUi()
     }
 
     // check to see if we can cancel
-    bool cancel = transaction->allowCancel();
+    bool cancel = progress.allowCancel;
     emit allowCancel(cancel);
     ui->cancelButton->setEnabled(cancel);
 }
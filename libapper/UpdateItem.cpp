@@ -0,0 +1,49 @@
+/***************************************************************************
+ *   Copyright (C) 2026 by agent                                           *
+ *   agent@local                                                           *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; see the file COPYING. If not, write to       *
+ *   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,  *
+ *   Boston, MA 02110-1301, USA.                                           *
+ ***************************************************************************/
+
+#include "UpdateItem.h"
+
+#include <QDBusMetaType>
+
+QDBusArgument &operator<<(QDBusArgument &argument, const UpdateItem &item)
+{
+    argument.beginStructure();
+    argument << item.info << item.packageID << item.summary;
+    argument.endStructure();
+    return argument;
+}
+
+const QDBusArgument &operator>>(const QDBusArgument &argument, UpdateItem &item)
+{
+    argument.beginStructure();
+    argument >> item.info >> item.packageID >> item.summary;
+    argument.endStructure();
+    return argument;
+}
+
+void registerUpdateItemTypes()
+{
+    static bool registered = false;
+    if (!registered) {
+        qDBusRegisterMetaType<UpdateItem>();
+        qDBusRegisterMetaType<UpdateItemList>();
+        registered = true;
+    }
+}
@@ -0,0 +1,52 @@
+/***************************************************************************
+ *   Copyright (C) 2026 by agent                                           *
+ *   agent@local                                                           *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; see the file COPYING. If not, write to       *
+ *   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,  *
+ *   Boston, MA 02110-1301, USA.                                           *
+ ***************************************************************************/
+
+#ifndef UPDATE_ITEM_H
+#define UPDATE_ITEM_H
+
+#include <QDBusArgument>
+#include <QList>
+#include <QMetaType>
+#include <QString>
+
+/**
+ * An entry of the update list apperd publishes on
+ * org.kde.apperd, marshalled as (uss)
+ */
+struct UpdateItem {
+    uint info = 0; // PackageKit::Transaction::Info
+    QString packageID;
+    QString summary;
+};
+typedef QList<UpdateItem> UpdateItemList;
+
+Q_DECL_EXPORT QDBusArgument &operator<<(QDBusArgument &argument, const UpdateItem &item);
+Q_DECL_EXPORT const QDBusArgument &operator>>(const QDBusArgument &argument, UpdateItem &item);
+
+/**
+ * Registers UpdateItem and UpdateItemList with QtDBus,
+ * must be called before they are sent or received
+ */
+Q_DECL_EXPORT void registerUpdateItemTypes();
+
+Q_DECLARE_METATYPE(UpdateItem)
+Q_DECLARE_METATYPE(UpdateItemList)
+
+#endif // UPDATE_ITEM_H